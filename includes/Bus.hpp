@@ -0,0 +1,69 @@
+#ifndef BUS_HPP
+# define BUS_HPP
+
+# include "ft_irc.hpp"
+
+// message of the Supervisor for the Server
+struct	s_busMsg
+{
+	std::string	type;		// "USER" (line to a client), "FWD" (command for a channel of this worker),
+							// "RENAME"/"DROP" (client of another worker), "CHAN" (a client joined or left
+							// a channel of another worker), "LOST" (a worker exited), or the answer to a
+							// claim ("CLAIMED", "TAKEN")
+	std::string	target;		// nickname (FWD: id of the worker executing it, LOST: id of the worker)
+	std::string	line;		// line to send to the client, command with its author (FWD),
+							// new nickname (RENAME), leaving message (DROP) or "+channel"/"-channel" (CHAN)
+};
+
+/**
+ * Worker's link to the Supervisor (multi-process mode), a SOCK_SEQPACKET socket:
+ * one message per packet, "TYPE target line".
+ *
+ * Each channel belongs to one worker, picked from its name (see getOwner()): the commands
+ * of the clients of the other workers about it are forwarded there (FWD), so that its
+ * modes and members are only in one place.
+ *
+ * Only used with the Server's lock held. Sends are blocking (the Supervisor never
+ * blocks, it queues what a worker can't take yet), nothing waits for an answer:
+ * the answer to a nickname claim is read with the other messages.
+ * The nicknames owned by the other workers are kept here, so that looking one up
+ * doesn't need a round trip.
+ */
+class Bus
+{
+	private:
+
+		int						_fd;
+		int						_id;			// this worker
+		int						_nbOfWorkers;
+		std::map<std::string, std::string>	_remoteNicks;	// nicknames of the clients of the other workers (in lower case -> as chosen)
+
+		bool	send(std::string const &msg);
+		int		receive(std::string &msg);
+		void	handle(std::string const &msg, std::vector<s_busMsg> &messages);
+
+		//UNUSED COPLIEN
+		Bus();
+		Bus(Bus const &toCopy);
+		Bus	&operator=(Bus const &toAssign);
+
+	public:
+
+		Bus(int fd, int id, int nbOfWorkers);
+		~Bus();
+
+		bool	claim(std::string const &nickname, std::string const &previous);
+		void	release(std::string const &nickname, std::string const &why);
+		void	requestShutdown();
+		bool	isRemote(std::string const &nickname) const;
+		std::string const	*getRemoteNickname(std::string const &nickname) const;
+		bool	sendToUser(std::string const &nickname, std::string const &line);
+		void	sendMembership(std::string const &nickname, std::string const &channel, bool isJoined);
+		int		getOwner(std::string const &channel) const;
+		bool	isLocal(std::string const &channel) const;
+		void	forward(int owner, std::string const &author, std::string const &command);
+		bool	collect(std::vector<s_busMsg> &messages);
+		int		getFd() const;
+};
+
+#endif
@@ -3,11 +3,28 @@
 
 # include "ft_irc.hpp"
 
+class User;
+
 /* #region Definitions */
-typedef std::list<User*>::iterator	user_iterator;
-/* #endregion */
 
-class User;
+// status of an user in a channel, the user is forgotten when none is left
+typedef uint8_t memberStatus;
+
+static const memberStatus MEMBER_JOINED = 0x01;		// 0000 0001 - receives the channel's messages
+static const memberStatus MEMBER_OPERATOR = 0x02;	// 0000 0010 - mode o
+static const memberStatus MEMBER_VOICE = 0x04;		// 0000 0100 - mode v (not handled yet)
+static const memberStatus MEMBER_INVITED = 0x08;	// 0000 1000 - can join a +i channel
+
+// link between an user and a channel, both reference it: leaving is O(1) on each side
+struct	s_membership
+{
+	User			*user;
+	Channel			*channel;
+	memberStatus	status;
+	size_t			channelSlot;	// index in the channel's members
+	size_t			userSlot;		// index in the user's memberships
+};
+/* #endregion */
 
 class Channel
 {
@@ -22,12 +39,16 @@ class Channel
 		std::string		_password;			// (+k)
 		int				_maxUsers;			// (+l)
 
-		std::list<User*>	_operators;		// (+o)
-		std::list<User*>	_normalUsers;
-		std::list<User*>	_invitedUsers;	// (+i)
+		std::vector<s_membership *>								_members;		// joined and invited users, packed (fanout)
+		HashMap<User *, s_membership *, s_pointerTraits<User> >	_memberIndex;	// membership of each user
+		int														_nbOfJoined;
+		int														_nbOfOperators;	// (+o)
 
-		User	*findUserFromList(std::list<User *> &role, std::string nickname);
-		bool	isChannelEmpty();
+		s_membership	*findMember(User *user);
+		void			addStatus(User *user, memberStatus status);
+		void			removeStatus(User *user, memberStatus status);
+		void			dropMember(s_membership *member);
+		bool			isChannelEmpty();
 
 	public:
 		
@@ -43,9 +64,10 @@ class Channel
 		std::string	const	&getTopic() const;
 		int					getMaxUsers() const;
 
-		bool	isInvited(std::string const &nickname);
-		bool	isOperator(std::string const &nickname);
-		bool	isNormal(std::string const &nickname);
+		bool	isMember(User *user);
+		bool	isInvited(User *user);
+		bool	isOperator(User *user);
+		bool	isNormal(User *user);
 
 		int		getTotalUsers() const;
 		bool	isPasswordCorrect(std::string const &pass);
@@ -74,13 +96,13 @@ class Channel
 		void	removeUser(User *user);
 		void	setUserLevel(User *user, userLevel lvl);
 		
-		User	*findUserInChannel(std::string nickname);
+		User	*findUserInChannel(std::string const &nickname);
 		
 		void	displayUsers(User *);
 		void	welcomeUser(User *user);
 		/* #endregion */
 
-		void				sendToChannel(User *user, std::string const &msg);
+		void				sendToChannel(User *user, Reply const &msg);
 		std::string const	sendTopic(User *user) const;
 
 	private:
@@ -52,6 +52,7 @@ class Nick: public Command
 		~Nick();
 
 		void	execute(User *user, s_msg &msg);
+		void	answer(User *user, std::string const &nickname, bool isFree);
 };
 
 class UserCMD: public Command
@@ -74,6 +75,16 @@ class Ping: public Command
 		void	execute(User *user, s_msg &msg);
 };
 
+class Pong: public Command
+{
+	public:
+
+		Pong(Server *server);
+		~Pong();
+
+		void	execute(User *user, s_msg &msg);
+};
+
 class Join: public Command
 {
 	public:
@@ -143,12 +154,6 @@ class Mode: public Command
 		~Mode();
 
 		void	execute(User *user, s_msg &msg);
-
-	private:
-
-		modeType	_last;
-		std::string	_modsToSend;
-		std::string	_paramsToSend;
 };
 
 class Oper: public Command
@@ -173,9 +178,27 @@ class Poweroff: public Command
 
 
 
+// checks done by execute() before a command runs
+# define CMD_REGISTERED	0x01	// client must be registered (451 ERR_NOTREGISTERED)
+# define CMD_SERVER_OP	0x02	// client must be a server operator (481 ERR_NOPRIVILEGES)
+# define CMD_SHARED		0x04	// only reads Users and Channels: executed under the shared lock (see ServerLock)
+
+# define CMD_SLOTS 32			// perfect hash table size (power of 2, see commandId()), its slots are
+								// regenerated by hand (g_cmdSlots): the build runs test_commands first
+
+// entry of the dispatch table, indexed by e_cmdId
+struct	s_cmdEntry
+{
+	char const	*name;
+	int			flags;
+};
+
 //Methodes de classe pour lancer un check de quelle fonction utiliser
+e_cmdId	commandId(char const *name, size_t len);
+char const	*commandName(e_cmdId id);
+bool	isSharedCommand(e_cmdId id);
 void	execute(Server *server, User *user, s_msg &msg);
-void	initCommands(Server *server, std::map<std::string, Command *> &commands);
-void	deleteCommands(std::map<std::string, Command *> &commands);
+void	initCommands(Server *server, Command *commands[CMD_COUNT]);
+void	deleteCommands(Command *commands[CMD_COUNT]);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,67 @@
+#ifndef EXECUTOR_HPP
+# define EXECUTOR_HPP
+
+# include "ft_irc.hpp"
+
+class Server;
+class User;
+
+// commands of a client waiting for the Executor (protected by the Executor's mutex)
+struct	s_commandQueue
+{
+	std::vector<s_command>	commands;	// ring of COMMANDS_QUEUE_MAX commands, allocated with the first ones
+	size_t					first;		// index of the first command in the ring
+	size_t					count;
+	bool					scheduled;	// in the ready list, or being executed
+	bool					stalled;	// client's input is paused until the queue has room
+	SharedBuffer			arena;		// block the client's Reactor copies the next lines into (not protected)
+};
+
+/**
+ * Pool of threads executing the clients' commands, out of the event loops.
+ *
+ * Reactors frame and parse the lines, then submit them to the client's
+ * queue. A client is given to one thread at a time, so its commands are executed
+ * in order; the threads take turns between clients (LINES_BUDGET commands each).
+ * Commands are executed with the Server's lock held (Users and Channels are shared):
+ * shared by the ones that only read them (PRIVMSG, PING...), which run in parallel,
+ * exclusive for the others. The Reactors only take the Executor's own mutex to submit:
+ * reads never wait for a command to end.
+ */
+class Executor
+{
+	private:
+
+		Server					*_server;
+		std::vector<pthread_t>	_threads;
+		pthread_mutex_t			_mutex;		// protects _ready, _stop and the clients' queues
+		pthread_cond_t			_cond;		// signaled when a client is ready
+		bool					_stop;
+		std::deque<User *>		_ready;		// clients with commands to execute
+
+		static void	*routine(void *executor);
+		void		work();
+		void		run(User *user, bool isShared);
+		bool		pop(User *user, bool isShared, s_command &command);
+		bool		isNextShared(User *user);
+		void		schedule(User *user);
+
+		//UNUSED COPLIEN
+		Executor();
+		Executor(Executor const &toCopy);
+		Executor	&operator=(Executor const &toAssign);
+
+	public:
+
+		Executor(Server *server, int nbOfThreads);
+		~Executor();
+
+		int		getRoom(User *user);
+		bool	submit(User *user, std::vector<s_command> &commands);
+		void	resume(User *user);
+		bool	drain(User *user);
+		void	forget(User *user);
+		void	stop();
+};
+
+#endif
@@ -0,0 +1,242 @@
+#ifndef HASHMAP_HPP
+# define HASHMAP_HPP
+
+# include "ft_irc.hpp"
+
+# define HASHMAP_MIN_CAPACITY 16	// slots of an empty table (power of 2)
+
+/**
+ * @brief RFC1459:2.2 lower case: {}|~ are the lower case of []\^
+ */
+inline char	ircToLower(char c)
+{
+	if (c >= 'A' && c <= '^')
+		return (c + ('a' - 'A'));
+	return (c);
+}
+
+/**
+ * @brief Name compared the way the server does (see ircToLower())
+ */
+inline std::string	ircCasefold(std::string const &name)
+{
+	std::string	folded(name);
+
+	for (size_t i = 0; i < folded.size(); i++)
+		folded[i] = ircToLower(folded[i]);
+	return (folded);
+}
+
+// nicknames and channels names: "Bob[1]" and "bob{1}" are the same key
+struct	s_casefoldTraits
+{
+	static size_t	hash(std::string const &key)
+	{
+		size_t	hash = 2166136261u;		// FNV-1a
+
+		for (size_t i = 0; i < key.size(); i++)
+		{
+			hash ^= static_cast<unsigned char>(ircToLower(key[i]));
+			hash *= 16777619u;
+		}
+		return (hash);
+	}
+
+	static bool	equal(std::string const &lhs, std::string const &rhs)
+	{
+		if (lhs.size() != rhs.size())
+			return (false);
+		for (size_t i = 0; i < lhs.size(); i++)
+		{
+			if (ircToLower(lhs[i]) != ircToLower(rhs[i]))
+				return (false);
+		}
+		return (true);
+	}
+};
+
+// objects known by their address (channel members): the low bits are the same
+// for all of them (alignment), the address is mixed before being masked
+template <typename T>
+struct	s_pointerTraits
+{
+	static size_t	hash(T const *key)
+	{
+		size_t	hash = reinterpret_cast<size_t>(key) >> 4;
+
+		hash *= 2654435761u;		// Knuth's multiplicative hash
+		return (hash ^ (hash >> 16));
+	}
+
+	static bool	equal(T const *lhs, T const *rhs) { return (lhs == rhs); }
+};
+
+/**
+ * Hash table with open addressing (linear probing), keys are hashed and compared by Traits.
+ *
+ * The hash of each key is kept in its slot: probing only compares the keys whose hash
+ * matches, and growing never hashes again. Erased slots are marked (tombstones) until
+ * the next rehash, the table stays at most 3/4 full counting them.
+ * Pointers returned by find() are valid until the next insert(), so are the iterators
+ * (erase() doesn't move anything: erasing while iterating is fine).
+ */
+template <typename Key, typename Value, typename Traits>
+class HashMap
+{
+	private:
+
+		enum	e_slotState { SLOT_EMPTY, SLOT_FULL, SLOT_ERASED };
+
+		struct	s_slot
+		{
+			Key			key;
+			Value		value;
+			size_t		hash;
+			e_slotState	state;
+
+			s_slot(): key(), value(), hash(0), state(SLOT_EMPTY) {}
+		};
+
+		std::vector<s_slot>	_slots;
+		size_t				_size;		// full slots
+		size_t				_used;		// full and erased slots
+
+		/**
+		 * @brief Slot of a key, or the capacity if it isn't in the table
+		 */
+		size_t	lookup(Key const &key, size_t hash) const
+		{
+			size_t	mask = _slots.size() - 1;
+
+			for (size_t i = hash & mask; _slots[i].state != SLOT_EMPTY; i = (i + 1) & mask)
+			{
+				if (_slots[i].state == SLOT_FULL && _slots[i].hash == hash && Traits::equal(_slots[i].key, key))
+					return (i);
+			}
+			return (_slots.size());
+		}
+
+		/**
+		 * @brief Moves the keys in a new table, tombstones are left behind
+		 */
+		void	rehash(size_t capacity)
+		{
+			std::vector<s_slot>	old(capacity);
+			size_t				mask = capacity - 1;
+
+			old.swap(_slots);
+			for (size_t i = 0; i < old.size(); i++)
+			{
+				if (old[i].state != SLOT_FULL)
+					continue ;
+
+				size_t	pos = old[i].hash & mask;
+
+				while (_slots[pos].state != SLOT_EMPTY)
+					pos = (pos + 1) & mask;
+				_slots[pos] = old[i];
+			}
+			_used = _size;
+		}
+
+	public:
+
+		// walks the full slots, in no particular order
+		class iterator
+		{
+			private:
+
+				std::vector<s_slot>	*_slots;
+				size_t				_pos;
+
+				void	skip()
+				{
+					while (_pos < _slots->size() && (*_slots)[_pos].state != SLOT_FULL)
+						_pos++;
+				}
+
+			public:
+
+				iterator(std::vector<s_slot> *slots, size_t pos): _slots(slots), _pos(pos) { skip(); }
+
+				Key const	&key() const { return ((*_slots)[_pos].key); }
+				Value		&value() const { return ((*_slots)[_pos].value); }
+
+				iterator	&operator++() { _pos++; skip(); return (*this); }
+				iterator	operator++(int) { iterator previous(*this); ++*this; return (previous); }
+				bool		operator==(iterator const &rhs) const { return (_pos == rhs._pos); }
+				bool		operator!=(iterator const &rhs) const { return (_pos != rhs._pos); }
+		};
+
+		HashMap(): _slots(HASHMAP_MIN_CAPACITY), _size(0), _used(0) {}
+		~HashMap() {}
+
+		size_t		size() const { return (_size); }
+		bool		empty() const { return (_size == 0); }
+		iterator	begin() { return (iterator(&_slots, 0)); }
+		iterator	end() { return (iterator(&_slots, _slots.size())); }
+
+		/**
+		 * @return the value of the key, NULL if it isn't in the table
+		 */
+		Value	*find(Key const &key)
+		{
+			size_t	pos = lookup(key, Traits::hash(key));
+
+			if (pos == _slots.size())
+				return (NULL);
+			return (&_slots[pos].value);
+		}
+
+		/**
+		 * @return false if the key was already in the table (its value isn't changed)
+		 */
+		bool	insert(Key const &key, Value const &value)
+		{
+			size_t	hash = Traits::hash(key);
+
+			if (lookup(key, hash) != _slots.size())
+				return (false);
+			if ((_used + 1) * 4 > _slots.size() * 3)
+				rehash((_size + 1) * 2 > _slots.size() ? _slots.size() * 2 : _slots.size());
+
+			size_t	mask = _slots.size() - 1;
+			size_t	pos = hash & mask;
+
+			while (_slots[pos].state == SLOT_FULL)
+				pos = (pos + 1) & mask;
+			if (_slots[pos].state == SLOT_EMPTY)
+				_used++;
+			_slots[pos].key = key;
+			_slots[pos].value = value;
+			_slots[pos].hash = hash;
+			_slots[pos].state = SLOT_FULL;
+			_size++;
+			return (true);
+		}
+
+		/**
+		 * @return false if the key wasn't in the table
+		 */
+		bool	erase(Key const &key)
+		{
+			size_t	pos = lookup(key, Traits::hash(key));
+
+			if (pos == _slots.size())
+				return (false);
+			_slots[pos].key = Key();
+			_slots[pos].value = Value();
+			_slots[pos].state = SLOT_ERASED;
+			_size--;
+			return (true);
+		}
+
+		void	clear()
+		{
+			std::vector<s_slot>(HASHMAP_MIN_CAPACITY).swap(_slots);
+			_size = 0;
+			_used = 0;
+		}
+};
+
+#endif
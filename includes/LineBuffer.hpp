@@ -0,0 +1,37 @@
+#ifndef LINEBUFFER_HPP
+# define LINEBUFFER_HPP
+
+# include "ft_irc.hpp"
+
+/**
+ * Fixed-capacity receive buffer of a connection.
+ *
+ * recv() writes directly after the stored data, complete lines are framed in
+ * place and given as non-owning slices (valid until the next prepare()), and
+ * the incomplete tail stays for the next read. The tail is moved to the front
+ * only when space is needed.
+ */
+class LineBuffer
+{
+	private:
+
+		char	_data[BUFFER_SIZE];
+		size_t	_start;		// first byte not consumed yet
+		size_t	_end;		// end of received data
+
+	public:
+
+		LineBuffer();
+		~LineBuffer();
+
+		char	*prepare();
+		size_t	space() const;
+		void	commit(size_t bytes);
+
+		bool	nextLine(char const *&line, size_t &len);
+		bool	hasLine() const;
+		size_t	size() const;
+		void	clear();
+};
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef LOCK_HPP
+# define LOCK_HPP
+
+# include "ft_irc.hpp"
+
+/**
+ * Holds a mutex for the lifetime of the object (released on every return path).
+ */
+class Lock
+{
+	private:
+
+		pthread_mutex_t	&_mutex;
+
+		//UNUSED COPLIEN
+		Lock();
+		Lock(Lock const &toCopy);
+		Lock	&operator=(Lock const &toAssign);
+
+	public:
+
+		explicit Lock(pthread_mutex_t &mutex): _mutex(mutex) { pthread_mutex_lock(&_mutex); }
+		~Lock() { pthread_mutex_unlock(&_mutex); }
+};
+
+/**
+ * Holds the Server's lock (readers-writer) for the lifetime of the object: shared by the
+ * commands that only read the Users and Channels (see isSharedCommand()), exclusive otherwise.
+ */
+class ServerLock
+{
+	private:
+
+		pthread_rwlock_t	&_lock;
+
+		//UNUSED COPLIEN
+		ServerLock();
+		ServerLock(ServerLock const &toCopy);
+		ServerLock	&operator=(ServerLock const &toAssign);
+
+	public:
+
+		explicit ServerLock(pthread_rwlock_t &lock, bool isShared = false): _lock(lock)
+		{
+			if (isShared)
+				pthread_rwlock_rdlock(&_lock);
+			else
+				pthread_rwlock_wrlock(&_lock);
+		}
+		~ServerLock() { pthread_rwlock_unlock(&_lock); }
+};
+
+#endif
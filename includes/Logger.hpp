@@ -0,0 +1,82 @@
+#ifndef LOGGER_HPP
+# define LOGGER_HPP
+
+# include "ft_irc.hpp"
+
+// message levels, the lowest enabled one is chosen at startup (IRC_LOG_LEVEL)
+enum	e_logLevel { LOG_DEV, LOG_INFO, LOG_ERROR, LOG_OFF };
+
+// MSG_DEV messages are compiled out if 0
+# ifndef LOG_DEV_MESSAGES
+#  define LOG_DEV_MESSAGES 1
+# endif
+# define LOG_RING_SIZE 1024		// records waiting to be written (power of 2), more are dropped
+# define LOG_TEXT_MAX 256		// bytes of a message, longer ones are cut
+# define LOG_FIELD_MAX 64		// bytes of a nickname or channel field
+# define LOG_DRAIN_INTERVAL 10	// ms the logging thread sleeps when there is nothing to write
+
+// one message, copied in the ring by the thread logging it
+struct	s_logRecord
+{
+	unsigned long	seq;					// ring position it is ready for (see Logger::log())
+	e_logLevel		level;
+	int				fd;						// client's socket, ERROR if none
+	char			nick[LOG_FIELD_MAX];	// empty if none
+	char			channel[LOG_FIELD_MAX];	// empty if none
+	char			text[LOG_TEXT_MAX];
+};
+
+/**
+ * Logging out of the event loops and command threads.
+ *
+ * Messages are copied in a bounded lock-free ring (multiple producers, one consumer)
+ * and written by a background thread, one write() per batch: a stalled stdout
+ * never blocks the server. If the ring is full the message is dropped and counted,
+ * the count is written once there is room again.
+ * Records are stamped by the logging thread when it writes them (at most a batch,
+ * LOG_DRAIN_INTERVAL ms after they were logged), with one clock read per batch:
+ * the threads logging never read the clock. The timestamp is only formatted again
+ * when the second changes.
+ */
+class Logger
+{
+	private:
+
+		static s_logRecord		*_ring;
+		static unsigned long	_enqueuePos;	// next position to fill (producers)
+		static unsigned long	_dequeuePos;	// next position to write (logging thread)
+		static unsigned long	_dropped;		// messages lost since the last write
+		static e_logLevel		_level;
+		static bool				_running;
+		static pthread_t		_thread;
+		static pthread_mutex_t	_writeLock;		// held while records are written (see fork handlers)
+		static time_t			_stampTime;		// second of _stamp
+		static char				_stamp[32];		// cached formatted timestamp
+
+		static void		*routine(void *unused);
+		static void		startThread();
+		static size_t	drain();
+		static void		format(s_logRecord const &record, time_t now, std::string &out, std::string &err);
+		static void		writeAll(int fd, std::string const &data);
+
+		static void		beforeFork();
+		static void		afterForkParent();
+		static void		afterForkChild();
+
+		//UNUSED COPLIEN
+		Logger();
+		Logger(Logger const &toCopy);
+		Logger	&operator=(Logger const &toAssign);
+		~Logger();
+
+	public:
+
+		static void	start();
+		static void	stop();
+
+		static bool	isEnabled(e_logLevel level);
+		static void	log(e_logLevel level, std::string const &text);
+		static void	log(e_logLevel level, char const *text, int fd, char const *nick, char const *channel);
+};
+
+#endif
@@ -0,0 +1,219 @@
+#ifndef POLLER_HPP
+# define POLLER_HPP
+
+# include "ft_irc.hpp"
+
+/**
+ * Readiness notification engine used by the Server's event loop.
+ *
+ * Events are expressed with the poll() flags (POLLIN, POLLOUT, POLLERR, POLLHUP)
+ * whatever the backend is. After wait(), getReady() only contains the FDs
+ * that actually have events, so the loop never walks idle connections.
+ * Clients' sockets and the server socket are read through the Poller (receive(),
+ * accept()) and written through send(): plain syscalls for poll and epoll, what
+ * the ring already completed for io_uring.
+ */
+class Poller
+{
+	protected:
+
+		std::vector<pollfd>	_ready;		// FDs reported by the last wait()
+
+		Poller();
+
+	public:
+
+		virtual ~Poller();
+
+		virtual void		add(int fd, short events) = 0;
+		virtual void		modify(int fd, short events) = 0;
+		virtual void		remove(int fd) = 0;
+		virtual int			wait(int timeout) = 0;
+		virtual std::string	getName() const = 0;
+
+		virtual void		addClient(int fd);
+		virtual void		addListener(int fd);
+		virtual int			accept(int fd, sockaddr_in &addr);
+		virtual ssize_t		receive(int fd, char *buffer, size_t len);
+		virtual size_t		getReceived(int fd) const;
+		virtual void		send(std::vector<s_send> &batch, size_t count);
+
+		std::vector<pollfd> const	&getReady() const;
+
+		static Poller	*create(std::string const &engine);
+		static void		sendNow(s_send &send);
+
+	private:
+
+		//UNUSED COPLIEN
+		Poller(Poller const &toCopy);
+		Poller	&operator=(Poller const &toAssign);
+};
+
+/**
+ * Fallback backend: poll() on a dense pollfd array.
+ * A FD -> slot table keeps add/modify/remove in O(1) (swap with last on removal).
+ */
+class PollPoller: public Poller
+{
+	private:
+
+		std::vector<pollfd>	_fds;		// List of socket FD that poll() must watch
+		std::vector<int>	_slots;		// index in _fds for each FD, -1 if not watched
+
+	public:
+
+		PollPoller();
+		~PollPoller();
+
+		void		add(int fd, short events);
+		void		modify(int fd, short events);
+		void		remove(int fd);
+		int			wait(int timeout);
+		std::string	getName() const;
+};
+
+/**
+ * Default backend: FDs are registered once in the kernel and epoll_wait()
+ * only returns the ready ones.
+ */
+class EpollPoller: public Poller
+{
+	private:
+
+		int							_epollFd;
+		int							_nbOfFds;
+		std::vector<epoll_event>	_events;	// output array of epoll_wait()
+
+	public:
+
+		EpollPoller();
+		~EpollPoller();
+
+		void		add(int fd, short events);
+		void		modify(int fd, short events);
+		void		remove(int fd);
+		int			wait(int timeout);
+		std::string	getName() const;
+};
+
+// what the ring holds for a FD (see UringPoller)
+enum	e_uringRole { URING_UNWATCHED, URING_READY, URING_CLIENT, URING_LISTENER };
+
+struct	s_uringFd
+{
+	e_uringRole		role;
+	short			events;			// asked by the Reactor (POLLIN, POLLOUT)
+	uint32_t		firstSeq;		// requests of the FD since it is watched have a seq from here
+	uint32_t		readSeq;		// multishot recv or accept armed
+	bool			readArmed;
+	bool			readCancelled;	// its cancellation is submitted, waiting for its last completion
+	uint32_t		pollSeq;		// one-shot poll armed
+	bool			pollArmed;
+	short			pollEvents;		// events of the armed poll
+	bool			pollIdle;		// last poll reported nothing asked (peer shut down its side)
+	bool			dirty;			// in _dirty
+	std::string		received;		// data completed by the recv, not read by the Reactor yet
+	size_t			offset;			// bytes of received already read
+	int				error;			// errno completed by the recv, 0 if none
+	bool			eof;			// the recv completed the end of the stream
+	std::deque<int>	accepted;		// sockets completed by the accept (or -errno), not taken yet
+};
+
+/**
+ * io_uring backend (raw syscalls, no liburing), a completion engine:
+ * - the server socket has a multishot accept, the accepted sockets wait in the
+ *   ring's state until the Server takes them (accept()),
+ * - each client has a multishot recv taking buffers from a provided buffer ring,
+ *   the data waits in its state until the Reactor reads it (receive()); the recv
+ *   is cancelled while the client is paused or while too much is waiting, so the
+ *   rest stays in the socket (flood control counts it with FIONREAD),
+ * - POLLOUT (and POLLERR/POLLHUP of a paused client) and the other FDs use
+ *   one-shot polls, re-armed while asked: level-triggered like epoll,
+ * - the sends of a loop turn are SENDMSG requests submitted together (see send()).
+ * Every request is queued as a SQE and submitted by the io_uring_enter() that
+ * waits for completions: a loop turn costs one syscall, plus one for its sends.
+ * A request's user_data holds its kind, the FD and a sequence number of the FD:
+ * completions of a FD that was closed (and its number reused) are ignored.
+ */
+class UringPoller: public Poller
+{
+	private:
+
+		int					_ringFd;
+
+		// submission queue (mmaped)
+		void				*_sqRing;
+		size_t				_sqRingSize;
+		unsigned			*_sqHead;
+		unsigned			*_sqTail;
+		unsigned			*_sqMask;
+		unsigned			*_sqArray;
+		unsigned			_sqEntries;
+		unsigned			_sqLocalTail;	// SQEs filled but not published yet are after *_sqTail
+		io_uring_sqe		*_sqes;
+		size_t				_sqesSize;
+
+		// completion queue (mmaped)
+		void				*_cqRing;
+		size_t				_cqRingSize;
+		unsigned			*_cqHead;
+		unsigned			*_cqTail;
+		unsigned			*_cqMask;
+		io_uring_cqe		*_cqes;
+
+		// provided buffers of the recv requests (mmaped)
+		io_uring_buf		*_bufRing;		// its tail overlays the first buffer's resv field
+		char				*_buffers;
+		size_t				_bufRingSize;
+
+		std::vector<s_uringFd>	_fds;			// state of each FD, by number
+		std::vector<uint32_t>	_seqs;			// next sequence number of each FD (kept when it is closed)
+		std::vector<int>		_dirty;			// FDs whose requests must be armed or cancelled
+		std::vector<short>		_revents;		// events completed for each FD since the last wait()
+		std::vector<int>		_completed;		// FDs with events in _revents
+		std::set<int>			_waiting;		// FDs with data or sockets waiting to be taken
+
+		std::vector<s_send>		*_batch;		// sends being completed (see send())
+		size_t					_sendsLeft;
+
+		io_uring_sqe	*getSqe();
+		void			submit(unsigned minComplete, int timeout);
+		void			reap();
+		void			complete(io_uring_cqe const &cqe);
+		void			completeRecv(int fd, uint32_t seq, io_uring_cqe const &cqe);
+		void			completeAccept(int fd, uint32_t seq, io_uring_cqe const &cqe);
+		void			completePoll(int fd, uint32_t seq, io_uring_cqe const &cqe);
+		void			report(int fd, short revents);
+		void			recycle(unsigned short bufferId);
+		s_uringFd		*getState(int fd, uint32_t seq);
+		void			watch(int fd, e_uringRole role, short events);
+		void			markDirty(int fd);
+		void			update(int fd);
+		void			arm(int fd, s_uringFd &state, bool isRead);
+		void			cancel(uint64_t userData);
+		void			reportWaiting(std::vector<int> &reports);
+		void			setBufferRing();
+		void			probe();
+		void			release();
+
+	public:
+
+		UringPoller();
+		~UringPoller();
+
+		void		add(int fd, short events);
+		void		modify(int fd, short events);
+		void		remove(int fd);
+		int			wait(int timeout);
+		std::string	getName() const;
+
+		void		addClient(int fd);
+		void		addListener(int fd);
+		int			accept(int fd, sockaddr_in &addr);
+		ssize_t		receive(int fd, char *buffer, size_t len);
+		size_t		getReceived(int fd) const;
+		void		send(std::vector<s_send> &batch, size_t count);
+};
+
+#endif
@@ -0,0 +1,136 @@
+#ifndef REACTOR_HPP
+# define REACTOR_HPP
+
+# include "ft_irc.hpp"
+
+class Server;
+class User;
+class Poller;
+
+// operations a thread can ask to the Reactor owning a client
+enum	postType { POST_ADOPT, POST_FLUSH, POST_EVICT, POST_INPUT, POST_EXEMPT, POST_UNEXEMPT, POST_STOP };
+
+struct	s_post
+{
+	postType	type;
+	int			fd;			// client's socket
+	User		*user;		// POST_ADOPT, POST_EXEMPT and POST_UNEXEMPT only
+};
+
+// keepalive and deadlines of a client, in ticks of its Reactor's wheel (owner thread only)
+struct	s_keepalive
+{
+	s_timer			timer;			// fires at the next deadline (see Reactor::handleTimeout())
+	unsigned long	connectedAt;
+	unsigned long	lastActivity;	// last data received
+	unsigned long	partialSince;	// when the incomplete line in the buffer started
+	bool			hasPartialLine;
+	unsigned long	pingSentAt;
+	bool			pingSent;		// keepalive PING waiting for an answer
+};
+
+// flood control of a client (owner thread only, see Server::canExecute())
+struct	s_flood
+{
+	unsigned long	penaltyUntil;	// loop clock (ms) at which the cost of the executed commands is paid
+	bool			throttled;		// input paused until the penalty goes down
+	unsigned long	resumeAt;		// tick at which a throttled client is read again
+	bool			exempt;			// server operator (FLOOD_EXEMPT_OPER)
+};
+
+/**
+ * Event loop owning a share of the clients' sockets.
+ *
+ * Reads, line framing and writes of a client only happen in the thread running
+ * its Reactor. Commands (which touch Users and Channels shared by all the
+ * Reactors) are executed while holding the Server's lock, by the Reactor or
+ * by the Executor's threads.
+ * Other threads never touch the Reactor's state: they post operations in its
+ * inbox (new client, messages to flush, eviction...) and wake it up through an eventfd.
+ * The first Reactor runs in the main thread and also watches the Server's FDs.
+ * Each Reactor has its own timer (TICK_INTERVAL) moving a timing wheel, which
+ * holds one timer per client for keepalive and timeouts.
+ */
+class Reactor
+{
+	private:
+
+		Server					*_server;
+		int						_id;
+		Poller					*_poller;
+		int						_wakeFd;		// eventfd written when the inbox is filled
+		int						_timerFd;		// periodic timer moving _wheel
+		TimingWheel				_wheel;			// clients' deadlines
+		unsigned long			_clock;			// monotonic time (ms) of the current loop turn
+		pthread_t				_thread;
+		bool					_threaded;		// runs in its own thread (see spawn())
+		bool					_started;		// between run()/spawn() and join()
+		bool					_running;
+
+		std::map<int, User *>	_clients;		// clients owned by this Reactor (int is FD)
+		std::set<int>			_pendingInput;	// clients with lines left to execute
+		std::set<int>			_evictions;		// clients to disconnect at the end of the loop turn
+		std::vector<int>		_toFlush;		// clients with messages queued during the loop turn
+		std::set<int>			_paused;		// clients whose input isn't watched (can't take more lines)
+		std::vector<s_send>		_sends;			// sends of the clients flushed together (see flushClients())
+		std::vector<s_command>	_commands;		// lines of a client parsed for the Executor (see handleLines())
+
+		pthread_mutex_t			_inboxMutex;	// protects _inbox
+		std::vector<s_post>		_inbox;			// operations posted by other threads
+
+		static void	*routine(void *reactor);
+		void		loop();
+		void		post(postType type, int fd, User *user);
+
+		void	handleInbox();
+		void	handleTimer();
+		void	handleTimeout(User *user);
+		void	armTimeout(User *user);
+		void	trackPartialLine(User *user);
+		void	handleIncomingData(int clientfd);
+		void	handleHangup(User *user);
+		bool	handleLines(User *user, int &linesBudget, bool &stalled);
+		void	pauseInput(User *user);
+		void	throttle(User *user);
+		void	throttleLocked(User *user);
+		bool	isExcessFlood(User *user);
+		void	updateClock();
+		void	restartInput(int fd);
+		void	handleOutgoingData(int clientfd);
+		void	handleEvictions();
+		void	flushClients();
+		User	*getClient(int fd);
+
+		//UNUSED COPLIEN
+		Reactor();
+		Reactor(Reactor const &toCopy);
+		Reactor	&operator=(Reactor const &toAssign);
+
+	public:
+
+		Reactor(Server *server, int id, std::string const &engine);
+		~Reactor();
+
+		void	run();
+		void	spawn();
+		void	join();
+		void	stop();
+
+		void	watch(int fd);
+		void	watchListener(int fd);
+		int		accept(int fd, sockaddr_in &addr);
+		void	adopt(User *user);
+		void	release(int fd);
+		void	watchOutput(int fd, bool enable);
+		void	scheduleFlush(int fd);
+		void	evict(int fd);
+		void	resumeInput(int fd);
+		void	setFloodExempt(User *user, bool exempt);
+
+		bool		isOwnThread() const;
+		int			getId() const;
+		unsigned long	getClock() const;
+		std::string	getEngineName() const;
+};
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef REPLY_HPP
+# define REPLY_HPP
+
+# include "ft_irc.hpp"
+
+# define REPLY_MAX_PARTS 16		// fragments of a reply (the longest macro of msg.hpp has 9)
+# define REPLY_DIGITS 64		// room for the numbers of a reply
+
+/**
+ * Message to a client, built by the macros of msg.hpp without any allocation.
+ *
+ * Constant fragments (":B&S 001 "...) are joined at compile time, the other ones
+ * are views of the arguments: a Reply only lives in the expression that builds it,
+ * it is written straight into the client's SendQ (see User::sendToClient()).
+ * Numbers are formatted in the Reply itself.
+ */
+class Reply
+{
+	private:
+
+		Slice	_parts[REPLY_MAX_PARTS];
+		size_t	_nbOfParts;
+		size_t	_size;
+		char	_digits[REPLY_DIGITS];
+		size_t	_digitsEnd;
+
+		void	add(char const *data, size_t len)
+		{
+			if (_nbOfParts == REPLY_MAX_PARTS)
+				throw std::length_error("reply has too many parts");
+			_parts[_nbOfParts++] = Slice(data, len);
+			_size += len;
+		}
+
+		void	addNumber(unsigned long value, bool isNegative)
+		{
+			char	buffer[24];
+			char	*begin = buffer + sizeof(buffer);
+
+			do
+			{
+				*--begin = '0' + value % 10;
+				value /= 10;
+			} while (value != 0);
+			if (isNegative)
+				*--begin = '-';
+
+			size_t	len = buffer + sizeof(buffer) - begin;
+
+			if (_digitsEnd + len > sizeof(_digits))
+				throw std::length_error("reply has too many numbers");
+			std::memcpy(_digits + _digitsEnd, begin, len);
+			add(_digits + _digitsEnd, len);
+			_digitsEnd += len;
+		}
+
+		//UNUSED COPLIEN: parts may point to _digits
+		Reply(Reply const &toCopy);
+		Reply	&operator=(Reply const &toAssign);
+
+	public:
+
+		Reply(): _nbOfParts(0), _size(0), _digitsEnd(0) {}
+		~Reply() {}
+
+		Reply	&operator<<(char const *str) { add(str, std::strlen(str)); return (*this); }
+		Reply	&operator<<(std::string const &str) { add(str.data(), str.size()); return (*this); }
+		Reply	&operator<<(Slice const &str) { add(str.data(), str.size()); return (*this); }
+		Reply	&operator<<(char const &c) { add(&c, 1); return (*this); }
+		Reply	&operator<<(int value) { addNumber(value < 0 ? -static_cast<long>(value) : value, value < 0); return (*this); }
+		Reply	&operator<<(long value) { addNumber(value < 0 ? -static_cast<unsigned long>(value) : value, value < 0); return (*this); }
+		Reply	&operator<<(unsigned int value) { addNumber(value, false); return (*this); }
+		Reply	&operator<<(unsigned long value) { addNumber(value, false); return (*this); }
+
+		size_t	size() const { return (_size); }
+
+		/**
+		 * @brief Appends the reply at the end of out
+		 */
+		void	appendTo(std::string &out) const
+		{
+			for (size_t i = 0; i < _nbOfParts; i++)
+				out.append(_parts[i].data(), _parts[i].size());
+		}
+
+		std::string	str() const
+		{
+			std::string	out;
+
+			out.reserve(_size);
+			appendTo(out);
+			return (out);
+		}
+
+		operator std::string() const { return (str()); }
+};
+
+#endif
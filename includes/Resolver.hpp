@@ -0,0 +1,68 @@
+#ifndef RESOLVER_HPP
+# define RESOLVER_HPP
+
+# include "ft_irc.hpp"
+
+// hostname found for a client's address
+struct	s_dnsResult
+{
+	int			fd;				// socket of the client that asked
+	in_addr		addr;
+	std::string	ip;				// numeric address
+	std::string	hostname;		// resolved name, numeric address if not found
+};
+
+// entry of the hostname cache
+struct	s_dnsEntry
+{
+	in_addr_t	addr;
+	std::string	hostname;
+	time_t		expiration;
+};
+
+/**
+ * Reverse DNS resolution out of the event loop thread.
+ *
+ * Requests are handled by a small pool of threads calling getnameinfo(), results
+ * are collected by the event loop when the notification FD is readable.
+ * Resolved names are kept in a LRU cache (DNS_CACHE_SIZE entries, DNS_CACHE_TTL secs),
+ * only used by the event loop thread.
+ */
+class Resolver
+{
+	private:
+
+		std::vector<pthread_t>					_threads;
+		pthread_mutex_t							_mutex;			// protects _requests, _results and _stop
+		pthread_cond_t							_cond;			// signaled when a request is added
+		bool									_stop;
+		int										_notifyFd;		// eventfd written when results are ready
+
+		std::queue<std::pair<int, in_addr> >	_requests;
+		std::vector<s_dnsResult>				_results;
+
+		std::list<s_dnsEntry>								_cache;			// most recently used first
+		std::map<in_addr_t, std::list<s_dnsEntry>::iterator>	_cacheIndex;
+
+		static void	*routine(void *resolver);
+		void		work();
+		void		stopThreads();
+		void		addToCache(s_dnsResult const &result);
+
+		//UNUSED COPLIEN
+		Resolver();
+		Resolver(Resolver const &toCopy);
+		Resolver	&operator=(Resolver const &toAssign);
+
+	public:
+
+		Resolver(int nbOfThreads);
+		~Resolver();
+
+		bool	lookup(in_addr const &addr, std::string &hostname);
+		void	resolve(int fd, in_addr const &addr);
+		void	collect(std::vector<s_dnsResult> &results);
+		int		getNotifyFd() const;
+};
+
+#endif
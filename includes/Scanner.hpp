@@ -0,0 +1,51 @@
+#ifndef SCANNER_HPP
+# define SCANNER_HPP
+
+# include "ft_irc.hpp"
+
+/**
+ * Byte scanning of received data: line endings when framing.
+ *
+ * Bytes are compared 32 (AVX2) or 16 (SSE2) at a time, the implementation is
+ * picked once at startup from what the CPU supports (CPUID). Every version gives
+ * the same results as the scalar one, which is kept for the other CPUs.
+ * The words of a line are split by a plain loop (see Server::parseLine()): they are a few
+ * bytes long, so setting up the vector compares costs more than it saves.
+ */
+class Scanner
+{
+	public:
+
+		typedef char const	*(*t_findByte)(char const *begin, char const *end, char c);
+
+		struct	s_impl
+		{
+			char const	*name;
+			t_findByte	findByte;
+		};
+
+	private:
+
+		static s_impl const	_impl;
+
+		static s_impl	select();
+
+		//UNUSED COPLIEN
+		Scanner();
+		Scanner(Scanner const &toCopy);
+		Scanner	&operator=(Scanner const &toAssign);
+		~Scanner();
+
+	public:
+
+		/**
+		 * @brief First byte equal to c in [begin, end), end if there is none
+		 */
+		static char const	*findByte(char const *begin, char const *end, char c) { return (_impl.findByte(begin, end, c)); }
+
+		static char const	*getName() { return (_impl.name); }
+
+		static std::vector<s_impl>	getImpls();
+};
+
+#endif
@@ -6,6 +6,11 @@
 class User;
 class Command;
 class Channel;
+class Poller;
+class Resolver;
+class Reactor;
+class Executor;
+class Bus;
 
 class Server
 {
@@ -16,35 +21,63 @@ class Server
 		const std::string	_password;
 
 		int					_serverSocket;
+		int					_spareFd;			// reserved FD, released when no FD is left for a new client
 		int					_endian;			// BIG_ENDIAN or LITTLE_ENDIAN
 		struct sockaddr_in	_addrServer;		// server address
 
-		std::vector<pollfd>	_fds;				// List of socket FD that poll() must watch
+		std::vector<Reactor *>	_reactors;		// event loops, the first one runs in the main thread
+		size_t				_nextReactor;		// Reactor given the next client (round robin)
+		pthread_rwlock_t	_lock;				// protects Users, Channels and Commands (shared by the Reactors, see ServerLock)
+		Resolver			*_resolver;			// clients' hostnames lookup
+		Executor			*_executor;			// threads executing the commands, NULL if done by the Reactors
+		Bus					*_bus;				// link to the Supervisor, NULL if not a worker process
+		int					_signalFd;			// signals (SIGINT) received as events
 		int					_nbOfClients;		// Total clients connected, not including server
 
 		std::map<int, User *>				_users;		//int is FD	
-		std::map<std::string, Command *>	_commands;
-		std::vector<Channel *>				_channels;
+		HashMap<std::string, User *, s_casefoldTraits>	_nicknames;	// registered nicknames (RFC1459 case)
+		HashMap<std::string, User *, s_casefoldTraits>	_claims;	// nicknames asked to the Supervisor, by the client waiting
+		Command								*_commands[CMD_COUNT];
+		channel_map							_channels;	// channels by name (RFC1459 case)
 
 		//--------------------------------------------------------------
 		//Methods
 
 		//init and setup
 
+		bool	setBus();
 		void	setPort(std::string const &port);
 		void	setEndian();
 		void	setServerSocket();
+		void	setSignalFd();
+		void	setReactors();
+		void	setExecutor();
 	
 		//events handle
 		
-		void	handlePollEvents();
 		void	handleNewConnection();
-		void	handleIncomingData(int &clientfd);
+		void	addClient(int clientSocket, sockaddr_in const &clientAddr);
+		bool	rejectConnection();
+		void	handleSignal();
+		void	handleResolvedHosts();
+		void	handleBus();
+		void	deliverBusMessages();
+		void	endClaim(std::string const &nickname, bool isFree);
+		void	resumeClient(User *user);
+		void	executeForwarded(std::string const &line, bool isBroadcast);
+		User	*newRemoteUser(std::string const &nickname, std::string const &username, std::string const &hostname);
+		void	deleteRemoteUser(User *user, std::string const &why);
+		void	deleteRemoteUsers();
+		void	leaveLostChannels(int worker);
+
+		//flood control
+		bool	canExecute(User *user);
+		void	chargeCommand(User *user, s_msg const &msg);
 
 		//tools
-		void	addToPoll(int fd, bool isServer);
-		void	deleteFromPoll(int fd);
+		void	addToPoll(int fd);
 		void	deleteUser(int fd);
+		void	forgetClaims(User *user);
 		void	disconnectAllClients();
 
 		//private getters
@@ -55,8 +88,7 @@ class Server
 		//  :prefix COMMAND arg1 arg2 ... :trailing
 		// prefix is optionnal and can be the server name or an user name
 		// trailing is a secial arg that can countain spaces and has ":" just before
-		void	parseIncomingData(std::string const &buffer, std::vector<s_msg> &fullMsg);
-		s_msg	parseLine(std::string const &line);
+		// (see parseLine(), public for the Executor)
 
 		//--------------------------------------------------------------
 		//UNUSED COPLIEN
@@ -73,12 +105,33 @@ class Server
 
 		void	start();
 		void	shutdown();
+		void	powerOff();
+
+		//reactors
+		void	handleServerEvent(int fd);
+		bool	executeLines(User *user, int &linesBudget);
+		bool	executeCommand(User *user, s_msg &msg);
+		bool	parseLines(User *user, int &linesBudget, std::vector<s_command> &commands);
+		s_msg	parseLine(char const *line, size_t len);
 
 		void	disconnectClient(User *client);
+		void	evictClient(User *client);
 		void	newChannel(std::string const &name, User *user);
 		void	newChannel(std::string const &name, User *user, std::string const &key);
 		void	deleteChannel(Channel *channel);
 		Channel *findChannel(std::string const &name);
+
+		//worker processes
+		bool	claimNickname(User *user, std::string const &nickname);
+		User	*getClaimant(std::string const &nickname);
+		void	indexNickname(User *user, std::string const &nickname);
+		bool	sendToRemoteUser(std::string const &nickname, std::string const &line);
+		std::string const	*getRemoteNickname(std::string const &nickname) const;
+		bool	mustForward(User *user, std::string const &channel) const;
+		void	forward(User *user, std::string const &channel, std::string const &command);
+		void	forwardToAll(User *user, std::string const &command);
+		User	*findUser(std::string const &nickname);
+		void	trackRemoteMember(User *user, std::string const &channel, bool isJoined);
 		
 
 
@@ -86,8 +139,11 @@ class Server
 		//Getters
 
 		std::string const					&getPassword() const;
-		std::map<std::string, Command *>	&getCommands();
+		pthread_rwlock_t					&getLock();
+		Executor							*getExecutor();
+		Command								*getCommand(e_cmdId id) const;
 		User								*getUserWithNickname(std::string const &nickname);
+		channel_map							&getChannels();
 
 		//--------------------------------------------------------------
 		//Setters
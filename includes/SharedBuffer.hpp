@@ -0,0 +1,126 @@
+#ifndef SHAREDBUFFER_HPP
+# define SHAREDBUFFER_HPP
+
+# include "ft_irc.hpp"
+
+/**
+ * Reference-counted block of bytes to send, the element of a client's SendQ.
+ *
+ * A block only referenced by one SendQ is written in place (see User::sendQBlock()).
+ * A line sent to many clients (channel fanout) is rendered once in a block queued
+ * by all of them: it is never written again, it is freed with its last reference.
+ * The lines of a client queued for the Executor are copied one after the other in a block,
+ * each command referencing it (see Server::parseLines()).
+ */
+class SharedBuffer
+{
+	private:
+
+		struct	s_block
+		{
+			std::string	data;
+			int			refs;
+		};
+
+		s_block	*_block;
+
+		void	acquire()
+		{
+			if (_block)
+				__atomic_add_fetch(&_block->refs, 1, __ATOMIC_RELAXED);
+		}
+		void	release()
+		{
+			if (_block && __atomic_sub_fetch(&_block->refs, 1, __ATOMIC_ACQ_REL) == 0)
+				delete _block;
+		}
+
+	public:
+
+		/**
+		 * @brief No block, until one is assigned
+		 */
+		SharedBuffer(): _block(NULL) {}
+
+		/**
+		 * @brief Empty block, ready to be written
+		 * @param capacity bytes reserved
+		 */
+		explicit SharedBuffer(size_t capacity): _block(new s_block)
+		{
+			_block->refs = 1;
+			_block->data.reserve(capacity);
+		}
+
+		/**
+		 * @brief Block holding one line, the line ending is added
+		 */
+		explicit SharedBuffer(Reply const &line): _block(new s_block)
+		{
+			_block->refs = 1;
+			_block->data.reserve(line.size() + 2);
+			line.appendTo(_block->data);
+			_block->data.append("\r\n", 2);
+		}
+
+		explicit SharedBuffer(std::string const &line): _block(new s_block)
+		{
+			_block->refs = 1;
+			_block->data.reserve(line.size() + 2);
+			_block->data.append(line).append("\r\n", 2);
+		}
+
+		SharedBuffer(SharedBuffer const &toCopy): _block(toCopy._block) { acquire(); }
+
+		SharedBuffer	&operator=(SharedBuffer const &toAssign)
+		{
+			if (_block != toAssign._block)
+			{
+				release();
+				_block = toAssign._block;
+				acquire();
+			}
+			return (*this);
+		}
+
+		~SharedBuffer() { release(); }
+
+		char const	*data() const { return (_block->data.data()); }
+		size_t		size() const { return (_block->data.size()); }
+
+		/**
+		 * @brief Line without its line ending (the block must hold a single line)
+		 */
+		std::string	line() const { return (_block->data.substr(0, size() - 2)); }
+
+		/**
+		 * @brief Whether other SendQs reference the block: it can't be written then
+		 */
+		bool	isShared() const { return (__atomic_load_n(&_block->refs, __ATOMIC_RELAXED) > 1); }
+
+		/**
+		 * @brief Bytes of the block, only if it isn't shared
+		 */
+		std::string	&edit() { return (_block->data); }
+
+		/**
+		 * @brief Whether len bytes can be appended without moving the ones already in the block
+		 */
+		bool	hasRoom(size_t len) const { return (_block && _block->data.size() + len <= _block->data.capacity()); }
+
+		/**
+		 * @brief Appends bytes after the ones already referenced (see hasRoom()), even if the
+		 * block is shared: these are never written again
+		 *
+		 * @return the copy of the bytes in the block
+		 */
+		char const	*append(char const *bytes, size_t len)
+		{
+			size_t	offset = _block->data.size();
+
+			_block->data.append(bytes, len);
+			return (_block->data.data() + offset);
+		}
+};
+
+#endif
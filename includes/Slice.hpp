@@ -0,0 +1,82 @@
+#ifndef SLICE_HPP
+# define SLICE_HPP
+
+# include "ft_irc.hpp"
+
+/**
+ * Non-owning view of bytes (a part of a received line).
+ *
+ * Only valid as long as the viewed bytes: a Slice that must be kept is converted
+ * to a std::string (implicitly, when given where a string is expected).
+ */
+class Slice
+{
+	private:
+
+		char const	*_data;
+		size_t		_size;
+
+	public:
+
+		Slice(): _data(""), _size(0) {}
+		Slice(char const *data, size_t size): _data(data), _size(size) {}
+
+		char const	*data() const { return (_data); }
+		size_t		size() const { return (_size); }
+		bool		empty() const { return (_size == 0); }
+		char		operator[](size_t i) const { return (_data[i]); }
+		std::string	str() const { return (std::string(_data, _size)); }
+		operator std::string() const { return (str()); }
+
+		bool	equals(char const *str, size_t len) const
+		{
+			return (_size == len && std::memcmp(_data, str, len) == 0);
+		}
+};
+
+inline bool	operator==(Slice const &lhs, char const *rhs) { return (lhs.equals(rhs, std::strlen(rhs))); }
+inline bool	operator!=(Slice const &lhs, char const *rhs) { return (!(lhs == rhs)); }
+inline bool	operator==(Slice const &lhs, std::string const &rhs) { return (lhs.equals(rhs.data(), rhs.size())); }
+inline bool	operator!=(Slice const &lhs, std::string const &rhs) { return (!(lhs == rhs)); }
+inline bool	operator==(std::string const &lhs, Slice const &rhs) { return (rhs == lhs); }
+inline bool	operator!=(std::string const &lhs, Slice const &rhs) { return (!(rhs == lhs)); }
+
+inline std::string	operator+(std::string const &lhs, Slice const &rhs)
+{
+	return (std::string(lhs).append(rhs.data(), rhs.size()));
+}
+
+inline std::string	operator+(char const *lhs, Slice const &rhs)
+{
+	return (std::string(lhs).append(rhs.data(), rhs.size()));
+}
+
+/**
+ * Middle parameters of a message, stored inline (RFC2812:2.3.1, max 14 + the trailing one)
+ */
+class Params
+{
+	private:
+
+		Slice	_items[MSG_MAX_PARAMS - 1];
+		size_t	_size;
+
+	public:
+
+		Params(): _size(0) {}
+
+		size_t	size() const { return (_size); }
+		bool	empty() const { return (_size == 0); }
+		bool	full() const { return (_size == MSG_MAX_PARAMS - 1); }
+		void	push_back(Slice const &param) { _items[_size++] = param; }
+
+		Slice const	&operator[](size_t i) const { return (_items[i]); }
+		Slice const	&at(size_t i) const
+		{
+			if (i >= _size)
+				throw std::out_of_range("message parameter");
+			return (_items[i]);
+		}
+};
+
+#endif
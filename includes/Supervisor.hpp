@@ -0,0 +1,64 @@
+#ifndef SUPERVISOR_HPP
+# define SUPERVISOR_HPP
+
+# include "ft_irc.hpp"
+
+class PollPoller;
+
+/**
+ * Multi-process mode: the first process forks the workers and routes their Bus messages.
+ *
+ * Each worker is a full server binding the same port (SO_REUSEPORT), the kernel
+ * spreads the connections. The Supervisor keeps the owner of every nickname
+ * (claims are granted here, so a nickname is unique among the workers), delivers
+ * private messages to the worker owning the nickname, and the commands about a channel
+ * to the worker owning the channel (see Bus::getOwner()).
+ * A worker that exits is restarted, only its clients and channels are lost: the members of these
+ * channels served by the other workers are kicked by their worker (LOST). The workers are only
+ * all stopped on a shutdown request: SIGINT to the Supervisor, or POWEROFF in a worker.
+ */
+class Supervisor
+{
+	private:
+
+		int							_nbOfWorkers;
+		std::vector<pid_t>			_pids;		// pid of each worker, ERROR if not running
+		std::vector<time_t>			_started;	// start time of each worker
+		std::vector<int>			_buses;		// supervisor's end of each worker's Bus, ERROR if closed
+		std::vector<std::deque<std::string> >	_queues;		// messages waiting for room in each worker's Bus
+		std::vector<size_t>			_queuedBytes;
+		std::map<std::string, int>	_nicks;		// nickname -> worker owning it
+		std::map<std::string, std::string>	_names;		// nickname -> nickname as chosen by its client (OWN)
+		int							_signalFd;	// SIGINT and SIGCHLD
+		PollPoller					*_poller;
+		bool						_stopping;
+		int							_workerId;	// in a worker: its number, ERROR in the Supervisor
+
+		int		spawn(int id);
+		int		handleSignal();
+		int		handleWorkerExit(int id, int status);
+		void	handleBus(int id);
+		void	handleMessage(int id, std::string const &msg);
+		void	send(int id, std::string const &msg);
+		void	flushQueue(int id);
+		bool	write(int id, std::string const &msg);
+		void	broadcast(int from, std::string const &msg);
+		void	closeBus(int id);
+		void	stopWorkers();
+		bool	hasWorkers() const;
+
+		//UNUSED COPLIEN
+		Supervisor();
+		Supervisor(Supervisor const &toCopy);
+		Supervisor	&operator=(Supervisor const &toAssign);
+
+	public:
+
+		Supervisor(int nbOfWorkers);
+		~Supervisor();
+
+		int		run();
+		int		getWorkerId() const;
+};
+
+#endif
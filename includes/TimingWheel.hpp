@@ -0,0 +1,54 @@
+#ifndef TIMINGWHEEL_HPP
+# define TIMINGWHEEL_HPP
+
+# include "ft_irc.hpp"
+
+# define WHEEL_LEVELS 4
+# define WHEEL_BITS 6
+# define WHEEL_SLOTS (1 << WHEEL_BITS)		// slots per level: level N slots last 64^N ticks
+
+// timer embedded in its owner: arming it never allocates
+struct	s_timer
+{
+	s_timer			*prev;		// NULL if not armed
+	s_timer			*next;
+	unsigned long	expires;	// tick at which it fires
+	int				fd;			// client's socket, given back when it fires
+};
+
+/**
+ * Hierarchical timing wheel (4 levels of 64 slots, 1 tick = TICK_INTERVAL).
+ *
+ * A timer is linked in the slot of the level matching its delay. Each tick only
+ * visits the current slot of level 0; when a level wraps, the next slot of the level
+ * above is spread again on the levels below. Arming or cancelling a timer is O(1)
+ * (intrusive doubly linked list), idle timers cost nothing until they fire.
+ */
+class TimingWheel
+{
+	private:
+
+		unsigned long	_now;
+		s_timer			_slots[WHEEL_LEVELS][WHEEL_SLOTS];	// circular lists heads
+
+		void	link(s_timer &timer);
+		void	cascade(int level);
+
+		//UNUSED COPLIEN
+		TimingWheel(TimingWheel const &toCopy);
+		TimingWheel	&operator=(TimingWheel const &toAssign);
+
+	public:
+
+		TimingWheel();
+		~TimingWheel();
+
+		void			arm(s_timer &timer, unsigned long expires);
+		void			cancel(s_timer &timer);
+		void			advance(unsigned long ticks, std::vector<int> &expired);
+		unsigned long	getNow() const;
+
+		static void		init(s_timer &timer, int fd);
+};
+
+#endif
@@ -15,6 +15,8 @@ enum	clientStatus
 
 class Server;
 class Channel;
+class Reactor;
+struct s_membership;
 
 class User
 {
@@ -22,20 +24,46 @@ class User
 
 		/* #region Attributes */
 		Server			*_server;
+		Reactor			*_reactor;		// event loop owning the socket
 		int				_socket_fd;
 		clientStatus	_status;
 		std::string     _nickname;
 		std::string     _username;
 		std::string     _realname;
 		std::string		_hostname;
+		std::string		_fullname;		// nick!~user@host, rendered again when one of them changes
 		std::string		_leavingMsg;
 		bool			_op;
-
-		std::vector<Channel *>	_joinedChannels;
-		std::vector<Channel *>	_invitedChannels;
+		bool			_hostPending;			// hostname is being resolved, _hostname is numeric
+		bool			_registrationPending;	// registration will complete once hostname is resolved
+		bool			_nickPending;			// NICK waits for the Supervisor's answer (see Server::claimNickname())
+		bool			_remote;				// client of another worker in a channel of this one (see Server::executeForwarded())
+		LineBuffer		_input;		// received data not executed yet
+
+		pthread_mutex_t			_sendLock;			// protects the SendQ: shared commands of several threads fill it
+		std::deque<SharedBuffer>	_sendQ;			// blocks of messages waiting to be sent
+		size_t					_sendQOffset;		// bytes of the first block already sent
+		size_t					_sendQBytes;		// total bytes waiting in _sendQ
+		bool					_outputWatched;		// POLLOUT is watched for this client
+		bool					_flushScheduled;	// queue will be flushed at the end of the loop turn
+		size_t					_sendQPeak;			// high-water mark of _sendQBytes
+		bool					_evicted;			// SendQ exceeded, will be disconnected (read without _sendLock)
+		bool					_quitting;			// QUIT executed out of its Reactor, will be disconnected
+
+		s_commandQueue			_commandQueue;		// commands waiting for the Executor
+		s_keepalive				_keepalive;			// timeouts, handled by the client's Reactor
+		s_flood					_flood;				// commands penalty, handled by the client's Reactor
+
+		std::vector<s_membership *>	_memberships;	// channels joined or invited to (see Channel::addStatus())
+		std::set<std::string>		_remoteChannels;	// channels of other workers joined (see Server::trackRemoteMember())
 		/* #endregion */
 
 		bool	isEmpty(std::string const &str) const;
+		void	updateFullname();
+		std::string	&sendQBlock(size_t len);
+		void	queued();
+		void	prepareSend(s_send &send);
+		void	watchSendQ();
 
 
 		/* #region Unused COPLIEN */
@@ -50,13 +78,19 @@ class User
 		~User();
 
 		void	sendToClient(std::string const &msg);
+		void	sendToClient(Reply const &reply);
+		void	sendToClient(SharedBuffer const &line);
+		bool	flush();
+		bool	beginFlush(s_send &send);
+		bool	endFlush(s_send &send);
 		void	welcome();
+		void	completeRegistration();
 
 		/* #region Channel */
-		void	addJoinedChannel(Channel *channel);
-		void	removeJoinedChannel(Channel *channel);
-		void	addInvitedChannel(Channel *channel);
-		void	removeInvitedChannel(Channel *channel);
+		void	attach(s_membership *membership);
+		void	detach(s_membership *membership);
+		void	setRemoteChannel(std::string const &channel, bool isJoined);
+		std::set<std::string>	&getRemoteChannels();
 
 		void	leaveChannel(Channel *channel, User *origin, std::string const &why);
 		void	leaveAllChannels(std::string const &why);
@@ -64,23 +98,45 @@ class User
 
 		/* #region GETTERS */
 		bool				isServerOp() const;
+		Reactor				*getReactor() const;
+		bool				isHostPending() const;
+		bool				isRegistrationPending() const;
+		bool				isWaiting() const;
+		bool				isRemote() const;
+		LineBuffer			&getInput();
+		size_t				getSendQBytes() const;
+		size_t				getSendQPeak() const;
+		size_t				getSendQMax() const;
+		bool				isEvicted() const;
+		bool				isDisconnecting() const;
+		bool				isOutputWatched() const;
+		s_commandQueue		&getCommandQueue();
+		s_keepalive			&getKeepalive();
+		s_flood				&getFlood();
 		int 				getSocketFd() const;
 		clientStatus		getStatus() const;
 		std::string	const	&getUsername() const;
 		std::string	const	&getNickname() const;
 		std::string	const	&getRealname() const;
 		std::string	const	&getHostname() const;
-		std::string			getFullname() const;
+		std::string	const	&getFullname() const;
+		std::string	const	&getLeavingMessage() const;
 		/* #endregion */
 
 		/* #region SETTERS */
+		void	setReactor(Reactor *reactor);
 		void	setStatus(clientStatus status);
 		void	setUsername(std::string const &username);
 		void	setNickname(std::string const &nickname);
 		void	setRealname(std::string const &realname);
 		void	setHostname(std::string const &hostname);
+		void	setHostPending(bool val);
+		void	setNickPending(bool val);
+		void	setResolvedHostname(std::string const &hostname);
 		void	setLeavingMessage(std::string const &msg);
 		void	setServerOP(bool val);
+		void	setRemote();
+		void	setQuitting();
 		/* #endregion */
 };
 
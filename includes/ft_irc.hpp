@@ -9,21 +9,38 @@
 # include <climits>		//MAX/MIN of types
 # include <cerrno>		//using errno
 # include <cstring>		//using strerror
+# include <cctype>		//std::toupper (commands names)
 # include <sstream>		//using string streams
 # include <algorithm>	//std::find
+# include <stdexcept>	//std::out_of_range...
 
 // Server
 # include <sys/socket.h>	//socket creation/usage tools
+# include <sys/ioctl.h>		//FIONREAD (bytes waiting in a socket)
+# include <sys/uio.h>		//iovec for sendmsg()
 # include <sys/poll.h>		//function poll()
+# include <sys/epoll.h>		//epoll engine (Poller)
+# include <sys/signalfd.h>	//signals received through the event loop
+# include <sys/timerfd.h>		//timeouts received through the event loop
+# include <sys/mman.h>		//io_uring rings mapping
+# include <sys/syscall.h>		//io_uring syscalls
+# include <linux/io_uring.h>	//io_uring engine (Poller)
+# include <sys/eventfd.h>		//threads -> event loop notifications
+# include <sys/wait.h>		//workers exit status (Supervisor)
+# include <pthread.h>		//Resolver, Reactor and Executor threads
+# include <unistd.h>		//close(), read()
 # include <netinet/in.h>	//contains sockaddr_in definition
+# include <netinet/tcp.h>	//TCP_DEFER_ACCEPT
 # include <arpa/inet.h>		//IP representations (inet_addr(), inet_ntoa(),...)
 # include <netdb.h>		//getnameinfo() + flags in handleNewConnection()
 
 // containers
 # include <vector>
 # include <map>
+# include <set>			// Server pending clients
 # include <list>		// Channel
 # include <queue>		// Command MODE
+# include <deque>		// User send queue
 
 //not sure if global or server specific
 # include <ctime>		//time and time structures manipulation
@@ -44,18 +61,145 @@
 
 //from bw: Server.hpp
 # define BACKLOG 5
+# define LISTEN_BACKLOG SOMAXCONN	// pending connections queue of the server socket
+# define ACCEPT_BUDGET 128			// max clients accepted during one loop turn
+# define DEFER_ACCEPT 10			// secs a connection can wait for its first data before being accepted anyway
+
+// max bytes queued for a client before it is disconnected (higher for server operators)
+# ifndef SENDQ_MAX
+#  define SENDQ_MAX 262144
+# endif
+# ifndef SENDQ_MAX_OPER
+#  define SENDQ_MAX_OPER 4194304
+# endif
+# define SENDQ_BLOCK 4096			// messages are written one after the other in blocks of this size
+# define SEND_IOV 256				// blocks of a client given to one send, more are sent right after
+
+// reverse DNS of clients' addresses (Resolver)
+# define DNS_THREADS 2
+# define DNS_CACHE_SIZE 1024		// max hostnames kept
+# define DNS_CACHE_TTL 3600		// secs a hostname is kept
 # define MAX_CONNECTIONS 1024
 # define BUFFER_SIZE 1024		// RFC2812:2.3, a message has max 510 char(512 with the \r\n follwing)
+# define MSG_MAX_LEN 512
+# define MSG_MAX_PARAMS 15		// RFC2812:2.3.1, 14 middle params + the trailing one
+
+// read path fairness: max bytes read and lines executed for one client during a loop turn,
+// what is left is processed during the next turns
+# ifndef RECV_BUDGET
+#  define RECV_BUDGET 8192
+# endif
+# ifndef LINES_BUDGET
+#  define LINES_BUDGET 16
+# endif
 # define TIMEOUT 60000 // 60 secs
 
-// structure for a full IRC command (prefix and trailing are optional)
+// flood control (RFC1459:8.10): each command adds its cost (ms) to the client's penalty,
+// its lines wait in the buffers while the penalty is more than FLOOD_BURST ms ahead of the clock
+# ifndef FLOOD_BURST
+#  define FLOOD_BURST 10000
+# endif
+# ifndef FLOOD_COST
+#  define FLOOD_COST 1000			// most commands, and each nickname target
+# endif
+# ifndef FLOOD_COST_LIGHT
+#  define FLOOD_COST_LIGHT 250		// PING, PONG
+# endif
+# ifndef FLOOD_COST_CHANNEL
+#  define FLOOD_COST_CHANNEL 2000	// each channel target of PRIVMSG
+# endif
+# ifndef FLOOD_RECVQ_MAX
+#  define FLOOD_RECVQ_MAX 8192		// bytes waiting while throttled before "Excess Flood"
+# endif
+# ifndef FLOOD_EXEMPT_OPER
+#  define FLOOD_EXEMPT_OPER 1		// server operators are not throttled
+# endif
+# define TICK_INTERVAL 1 // secs between two timer events (ticks of the Reactors' timing wheels)
+
+// client timeouts (secs), checked by the Reactors' timing wheels
+# ifndef REGISTRATION_TIMEOUT
+#  define REGISTRATION_TIMEOUT 60	// to complete the registration (PASS, NICK, USER)
+# endif
+# ifndef PING_INTERVAL
+#  define PING_INTERVAL 120			// silence before a keepalive PING is sent
+# endif
+# ifndef PING_TIMEOUT
+#  define PING_TIMEOUT 60			// to answer the keepalive PING
+# endif
+# ifndef LINE_TIMEOUT
+#  define LINE_TIMEOUT 30			// to complete a partial line (slowloris)
+# endif
+
+// default event loop engine ("io_uring", "epoll" or "poll"), can be set in .env
+// or overridden at startup with the IRC_ENGINE environment variable
+# ifndef ENGINE
+#  define ENGINE "epoll"
+# endif
+
+// number of event loop threads sharing the clients (1: everything in the main thread),
+// can be overridden at startup with the IRC_REACTORS environment variable
+# ifndef REACTORS
+#  define REACTORS 1
+# endif
+# define REACTORS_MAX 64
+
+// number of threads executing the commands (0: executed by the Reactors),
+// can be overridden at startup with the IRC_WORKERS environment variable
+# ifndef WORKERS
+#  define WORKERS 0
+# endif
+# define WORKERS_MAX 64
+# define COMMANDS_QUEUE_MAX 32		// max commands of a client waiting for the Executor
+# define COMMANDS_BLOCK 4096		// lines queued for the Executor are copied one after the other in blocks of this size
+
+// number of worker processes sharing the port with SO_REUSEPORT (1: no Supervisor),
+// can be overridden at startup with the IRC_PROCESSES environment variable
+# ifndef PROCESSES
+#  define PROCESSES 1
+# endif
+# define PROCESSES_MAX 64
+# define WORKER_MIN_UPTIME 2		// a worker exiting sooner after its start isn't restarted (seconds)
+# define BUS_MSG_MAX 2048			// max size of a message between a worker and the Supervisor
+# define BUS_QUEUE_MAX 1048576		// bytes queued for a worker before the lines for its clients are dropped
+
+# include "Slice.hpp"
+# include "Reply.hpp"
+# include "SharedBuffer.hpp"
+# include "HashMap.hpp"
+
+// commands known by the server, resolved once when a line is parsed (see commandId())
+enum	e_cmdId { CMD_UNKNOWN, CMD_QUIT, CMD_PASS, CMD_NICK, CMD_USER, CMD_PING, CMD_PONG, CMD_JOIN, CMD_PART,
+	CMD_KICK, CMD_INVITE, CMD_PRIVMSG, CMD_TOPIC, CMD_MODE, CMD_OPER, CMD_POWEROFF, CMD_CAP, CMD_COUNT };
+
+// structure for a full IRC command (prefix and trailing are optional),
+// views into the received line: only valid while the line is (see Server::parseLine())
 struct	s_msg
 {
-	std::string					prefix;
-	std::string					cmd;
-	std::vector<std::string>	args;
-	std::string					trailing;
-	bool						trailing_sign;
+	Slice	prefix;
+	Slice	cmd;
+	e_cmdId	cmdId;
+	Params	args;
+	Slice	trailing;
+	bool	trailing_sign;
+};
+
+// command of a client queued for the Executor, parsed once by its Reactor:
+// the views of msg are into block, which holds a copy of the line (see Server::parseLines())
+struct	s_command
+{
+	SharedBuffer	block;
+	s_msg			msg;
+	bool			isShared;	// can run under the Server's shared lock (see isSharedCommand())
+};
+
+// messages queued for a client, sent with the ones of the other clients at the end
+// of the loop turn (see Poller::send())
+struct	s_send
+{
+	int		fd;
+	msghdr	msg;
+	iovec	iov[SEND_IOV];
+	ssize_t	result;		// bytes sent, or -errno
 };
 
 // Channel Modes
@@ -75,15 +219,24 @@ typedef	std::pair<modeType, modeVal> modePair;
 
 class User;
 class Channel;
-typedef std::vector<pollfd>::iterator		pollfd_iterator;
 typedef std::map<int, User *>::iterator		client_iterator;
-typedef std::vector<s_msg>::iterator		msg_iterator;
-typedef std::vector<Channel *>::iterator	channel_iterator;
+typedef HashMap<std::string, Channel *, s_casefoldTraits>	channel_map;
 
 /********************************
  *		Project includes		*
  *******************************/
+# include "Logger.hpp"
 # include "msg.hpp"
+# include "Lock.hpp"
+# include "Poller.hpp"
+# include "TimingWheel.hpp"
+# include "Reactor.hpp"
+# include "Scanner.hpp"
+# include "LineBuffer.hpp"
+# include "Resolver.hpp"
+# include "Executor.hpp"
+# include "Bus.hpp"
+# include "Supervisor.hpp"
 # include "Server.hpp"
 # include "User.hpp"
 # include "Commands.hpp"
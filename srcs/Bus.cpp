@@ -0,0 +1,210 @@
+#include "ft_irc.hpp"
+
+/* #region Constructor/Destructor */
+
+/**
+ * @param fd worker's end of the socket pair created by the Supervisor
+ * @param id number of this worker
+ * @param nbOfWorkers number of worker processes
+ */
+Bus::Bus(int fd, int id, int nbOfWorkers): _fd(fd), _id(id), _nbOfWorkers(nbOfWorkers) {}
+
+Bus::~Bus()
+{
+	if (_fd != ERROR)
+		close(_fd);
+}
+/* #endregion */
+
+/* #region PUBLIC */
+
+/**
+ * @brief Asks the Supervisor for a nickname, the answer comes later (see collect())
+ *
+ * @param nickname nickname wanted by a client of this worker
+ * @param previous nickname the client leaves, "*" if it had none
+ * @return false if a client of another worker is known to have it (or the Supervisor is gone):
+ * there is nothing to wait for
+ */
+bool	Bus::claim(std::string const &nickname, std::string const &previous)
+{
+	return (!isRemote(nickname) && send("CLAIM " + nickname + " " + previous));
+}
+
+/**
+ * @brief The nickname isn't used by this worker anymore (disconnection)
+ *
+ * @param why leaving message given to the channels of the other workers, "*" if none
+ */
+void	Bus::release(std::string const &nickname, std::string const &why)
+{
+	send("RELEASE " + nickname + " " + why);
+}
+
+/**
+ * @brief POWEROFF: the Supervisor stops all the workers
+ */
+void	Bus::requestShutdown()
+{
+	send("SHUTDOWN");
+}
+
+/**
+ * @brief Whether the nickname belongs to a client of another worker, in any case
+ */
+bool	Bus::isRemote(std::string const &nickname) const
+{
+	return (_remoteNicks.count(ircCasefold(nickname)) != 0);
+}
+
+/**
+ * @brief Nickname of a client of another worker, as chosen by the client (in any case)
+ *
+ * @return NULL if no other worker has a client with this nickname
+ */
+std::string const	*Bus::getRemoteNickname(std::string const &nickname) const
+{
+	std::map<std::string, std::string>::const_iterator	it = _remoteNicks.find(ircCasefold(nickname));
+
+	if (it == _remoteNicks.end())
+		return (NULL);
+	return (&it->second);
+}
+
+/**
+ * @brief Sends a line to a client of another worker
+ *
+ * @return false if no other worker has a client with this nickname
+ */
+bool	Bus::sendToUser(std::string const &nickname, std::string const &line)
+{
+	if (!isRemote(nickname))
+		return (false);
+	send("USER " + nickname + " " + line);
+	return (true);
+}
+
+/**
+ * @brief Tells the worker of a client that it joined or left a channel of this one
+ * (see Server::trackRemoteMember())
+ */
+void	Bus::sendMembership(std::string const &nickname, std::string const &channel, bool isJoined)
+{
+	send("CHAN " + nickname + " " + (isJoined ? "+" : "-") + channel);
+}
+
+/**
+ * @brief Worker owning a channel: the one executing the commands about it
+ * @note Picked from the name (in any case), every worker finds the same one.
+ */
+int	Bus::getOwner(std::string const &channel) const
+{
+	return (s_casefoldTraits::hash(channel) % _nbOfWorkers);
+}
+
+bool	Bus::isLocal(std::string const &channel) const { return (getOwner(channel) == _id); }
+
+/**
+ * @brief Gives a command to another worker (see getOwner()), to be executed there
+ * on behalf of a client of this one
+ *
+ * @param owner worker executing it, ERROR for all of them
+ * @param author "nick user host" of the client
+ * @param command line of the command
+ */
+void	Bus::forward(int owner, std::string const &author, std::string const &command)
+{
+	send("FWD " + (owner == ERROR ? std::string("*") : to_string(owner)) + " " + author + " " + command);
+}
+
+/**
+ * @brief Reads the pending messages of the Supervisor (when the Bus FD is readable)
+ *
+ * @param messages filled with the answers to the claims and the lines to send to local clients
+ * @return false if the Supervisor is gone
+ */
+bool	Bus::collect(std::vector<s_busMsg> &messages)
+{
+	std::string	msg;
+	int			ret;
+
+	while ((ret = receive(msg)) > 0)
+		handle(msg, messages);
+	return (ret != 0);
+}
+
+int	Bus::getFd() const { return _fd; }
+
+/* #endregion */
+
+/* #region PRIVATE */
+
+/**
+ * @brief Sends one message to the Supervisor
+ * @return false if the Supervisor is gone
+ */
+bool	Bus::send(std::string const &msg)
+{
+	while (::send(_fd, msg.data(), std::min<size_t>(msg.size(), BUS_MSG_MAX), MSG_NOSIGNAL) == ERROR)
+	{
+		if (errno != EINTR)
+		{
+			MSG_ERR(strerror(errno));
+			return (false);
+		}
+	}
+	return (true);
+}
+
+/**
+ * @brief Receives one message of the Supervisor, without blocking
+ *
+ * @return size of the message, 0 if the Supervisor is gone, ERROR if there is nothing to read
+ */
+int	Bus::receive(std::string &msg)
+{
+	char	buffer[BUS_MSG_MAX];
+	ssize_t	ret;
+
+	while ((ret = recv(_fd, buffer, sizeof(buffer), MSG_DONTWAIT)) == ERROR && errno == EINTR)
+		;
+	if (ret > 0)
+		msg.assign(buffer, ret);
+	return (ret);
+}
+
+/**
+ * @brief Applies a message of the Supervisor: nickname ownership changes
+ * are kept, the others are given to the Server (as RENAME and DROP, for the
+ * clients of other workers in the channels of this one)
+ */
+void	Bus::handle(std::string const &msg, std::vector<s_busMsg> &messages)
+{
+	size_t		typeEnd = msg.find(' ');
+	size_t		targetEnd = msg.find(' ', typeEnd + 1);
+	s_busMsg	busMsg;
+
+	if (typeEnd == std::string::npos)
+		return ;
+	busMsg.type = msg.substr(0, typeEnd);
+	busMsg.target = msg.substr(typeEnd + 1, targetEnd - typeEnd - 1);
+	if (targetEnd != std::string::npos)
+		busMsg.line = msg.substr(targetEnd + 1);
+
+	// OWN and RENAME give the nickname as chosen, DROP and the previous one of RENAME in lower case
+	if (busMsg.type == "OWN")
+		_remoteNicks[ircCasefold(busMsg.target)] = busMsg.target;
+	else
+	{
+		if (busMsg.type == "DROP")
+			_remoteNicks.erase(busMsg.target);
+		else if (busMsg.type == "RENAME")
+		{
+			_remoteNicks.erase(busMsg.target);
+			_remoteNicks[ircCasefold(busMsg.line)] = busMsg.line;
+		}
+		messages.push_back(busMsg);
+	}
+}
+
+/* #endregion */
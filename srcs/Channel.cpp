@@ -3,18 +3,18 @@
 /* #region Constructor/Destructor  */
 
 Channel::Channel(Server *server, std::string name, User *user):
-_server(server), _channelName(name), _modes(0), _maxUsers(0)
+_server(server), _channelName(name), _modes(0), _maxUsers(0), _nbOfJoined(0), _nbOfOperators(0)
 {
-	msg_log(MSG_CHAN_CREATED(user->getNickname(), _channelName));
+	msg_log(MSG_CHAN_CREATED, user->getSocketFd(), user->getNickname(), _channelName);
 	_topic.empty();
 	_password.empty();
 	addUser(user, OPERATOR);
 }
 
 Channel::Channel(Server *server, std::string name, User *user, std::string const &password):
-_server(server), _channelName(name), _modes(0), _password(password), _maxUsers(0)
+_server(server), _channelName(name), _modes(0), _password(password), _maxUsers(0), _nbOfJoined(0), _nbOfOperators(0)
 {
-	msg_log(MSG_CHAN_CREATED(user->getNickname(), _channelName));
+	msg_log(MSG_CHAN_CREATED, user->getSocketFd(), user->getNickname(), _channelName);
 	_topic.empty();
 	setMode(KEY, PLUS);
 	addUser(user, OPERATOR);
@@ -22,11 +22,14 @@ _server(server), _channelName(name), _modes(0), _password(password), _maxUsers(0
 
 Channel::~Channel()
 {
-	// Remove the channel from the lists of all invited users
-	for (std::list<User *>::iterator it = _invitedUsers.begin(); it != _invitedUsers.end(); it++)
-		(*it)->removeInvitedChannel(this);
+	// Unlink the users still referencing the channel (invited ones)
+	for (std::vector<s_membership *>::iterator it = _members.begin(); it != _members.end(); it++)
+	{
+		(*it)->user->detach(*it);
+		delete *it;
+	}
 
-	msg_log("Channel " + _channelName + " channel has been deleted.");
+	msg_log(MSG_CHAN_DELETED, ERROR, "", _channelName);
 }
 /* #endregion */
 
@@ -35,18 +38,18 @@ Channel::~Channel()
 /**
  * @brief Sends a message to all users (operators and normal) of the channel
  * If the given user isn't NULL, send to all except him
+ * @note The message is rendered once, in a buffer shared by the SendQs of the members.
+ * @note In multi-process mode, the members of the other workers get it through the Supervisor
+ * (see User::isRemote()).
  */
-void	Channel::sendToChannel(User *user, std::string const &msg)
+void	Channel::sendToChannel(User *user, Reply const &msg)
 {
-	for (std::list<User *>::iterator it = _operators.begin(); it != _operators.end(); it++)
-	{
-		if (user == NULL || (*it)->getNickname() != user->getNickname())
-				(*it)->sendToClient(msg);
-	}
-	for (std::list<User *>::iterator it = _normalUsers.begin(); it != _normalUsers.end(); it++)
+	SharedBuffer	line(msg);
+
+	for (std::vector<s_membership *>::iterator it = _members.begin(); it != _members.end(); it++)
 	{
-		if (user == NULL || (*it)->getNickname() != user->getNickname())
-				(*it)->sendToClient(msg);
+		if (((*it)->status & MEMBER_JOINED) && (*it)->user != user)
+			(*it)->user->sendToClient(line);
 	}
 }
 
@@ -69,81 +72,67 @@ void	Channel::addUser(User *user, userLevel lvl)
 	if (lvl == INVITED)
 	{
 		// if already invited, do nothing
-		if (isInvited(user->getNickname()))
+		if (isInvited(user))
 			return ;
-		_invitedUsers.push_back(user);
-		user->addInvitedChannel(this);
+		addStatus(user, MEMBER_INVITED);
 	}
 	else
 	{
-
-
-		// If user was invited, delete the invitation
-		if (isInvited(user->getNickname()))
-			_invitedUsers.remove(user);
-
-		// check lvl and add to the correct list
-		if (lvl == NORMAL)
-			_normalUsers.push_back(user);
-		else if (lvl == OPERATOR)
-			_operators.push_back(user);
+		// check lvl and set the status, the invitation is used
+		addStatus(user, lvl == OPERATOR ? MEMBER_JOINED | MEMBER_OPERATOR : MEMBER_JOINED);
+		removeStatus(user, MEMBER_INVITED);
 
 		//Send the message ":fullname JOIN :#channel"
 		sendToChannel(NULL, SEND_JOIN(user->getFullname(), _channelName));
 
-		user->addJoinedChannel(this);
-		msg_log(user->getNickname() + " joined the channel " + _channelName);
+		msg_log(MSG_CHAN_JOINED, user->getSocketFd(), user->getNickname(), _channelName);
 		welcomeUser(user);
 	}
 }
 
 void	Channel::setUserLevel(User *user, userLevel lvl)
 {
-	if (lvl == NORMAL && !isNormal(user->getNickname()))
-	{
-		_operators.remove(user);
-		_normalUsers.push_back(user);
-	}
-	else if (lvl == OPERATOR && !isOperator(user->getNickname()))
-	{
-		_normalUsers.remove(user);
-		_operators.push_back(user);
-	}
+	if (lvl == NORMAL && isOperator(user))
+		removeStatus(user, MEMBER_OPERATOR);
+	else if (lvl == OPERATOR && isNormal(user))
+		addStatus(user, MEMBER_OPERATOR);
 }
 
 /**
- * @brief Remove an user from Channel
+ * @brief Remove an user from Channel (or its invitation), unlinks both sides
  */
 void	Channel::removeUser(User *user)
 {
-	if (isInvited(user->getNickname()))
-		_invitedUsers.remove(user);
-	else
+	s_membership	*member = findMember(user);
+
+	if (member == NULL)
+		return ;
+
+	bool	wasJoined = member->status & MEMBER_JOINED;
+
+	removeStatus(user, member->status);
+	if (wasJoined)
 	{
-		if (isOperator(user->getNickname()))
-			_operators.remove(user);
-		else
-			_normalUsers.remove(user);
-		msg_log(user->getNickname() + " has left the channel " + _channelName);
+		msg_log(MSG_CHAN_LEFT, user->getSocketFd(), user->getNickname(), _channelName);
 
 		if (isChannelEmpty())
 			_server->deleteChannel(this);
 	}
-
 }
 
 /**
  * @brief Finds an user with his nickname and returns a pointer to this user
  * 
  * @param nickname the user to find
+ * @return NULL if nobody in the channel has this nickname
  */
-User	*Channel::findUserInChannel(std::string nickname)
+User	*Channel::findUserInChannel(std::string const &nickname)
 {
-	User *user = NULL;
-	user = findUserFromList(_operators, nickname);
-	if (user == NULL)
-		user = findUserFromList(_normalUsers, nickname);
-	return user;
+	User	*user = _server->getUserWithNickname(nickname);
+
+	if (user == NULL || !isMember(user))
+		return (NULL);
+	return (user);
 }
 
 /**
@@ -155,25 +144,28 @@ void	Channel::displayUsers(User *user)
 	std::string	msg;
 	bool		first = true;
 
-	for (std::list<User *>::iterator it = _operators.begin(); it != _operators.end(); it++)
+	for (std::vector<s_membership *>::iterator it = _members.begin(); it != _members.end(); it++)
 	{
+		if (!((*it)->status & MEMBER_OPERATOR))
+			continue ;
 		if (first)
 		{
 			msg += "@";
-			msg += (*it)->getNickname();
+			msg += (*it)->user->getNickname();
 			first = false;
 		}
 		else
 		{
 			msg += " @";
-			msg += (*it)->getNickname();
+			msg += (*it)->user->getNickname();
 		}
 	}
-	first = true;
-	for (std::list<User *>::iterator it = _normalUsers.begin(); it != _normalUsers.end(); it++)
+	for (std::vector<s_membership *>::iterator it = _members.begin(); it != _members.end(); it++)
 	{
-			msg += " ";
-			msg += (*it)->getNickname();
+		if (((*it)->status & (MEMBER_JOINED | MEMBER_OPERATOR)) != MEMBER_JOINED)
+			continue ;
+		msg += " ";
+		msg += (*it)->user->getNickname();
 	}
 	if (!msg.empty())
 	{
@@ -232,11 +224,15 @@ std::string const	&Channel::getTopic() const { return (_topic); }
 std::string const	&Channel::getPassword() const { return(_password); }
 int					Channel::getMaxUsers() const { return(_maxUsers); }
 
-bool	Channel::isInvited(std::string const &nickname) { return (findUserFromList(_invitedUsers, nickname) != NULL);  }
-bool	Channel::isOperator(std::string const &nickname) { return (findUserFromList(_operators, nickname) != NULL); }
-bool	Channel::isNormal(std::string const &nickname) { return (findUserFromList(_normalUsers, nickname) != NULL); }
+/**
+ * @brief Status of an user in the channel, found in O(1) (see findMember())
+ */
+bool	Channel::isMember(User *user) { s_membership *member = findMember(user); return (member && (member->status & MEMBER_JOINED)); }
+bool	Channel::isInvited(User *user) { s_membership *member = findMember(user); return (member && (member->status & MEMBER_INVITED)); }
+bool	Channel::isOperator(User *user) { s_membership *member = findMember(user); return (member && (member->status & MEMBER_OPERATOR)); }
+bool	Channel::isNormal(User *user) { return (isMember(user) && !isOperator(user)); }
 
-int	Channel::getTotalUsers() const { return (_operators.size() + _normalUsers.size()); }
+int	Channel::getTotalUsers() const { return (_nbOfJoined); }
 /* #endregion */
 
 /* #region SETTERS */
@@ -252,16 +248,81 @@ void	Channel::setMaxUsers(int max) { _maxUsers = max; }
 /* #region PRIVATE */
 
 /**
- * @brief Finds an user with his nickname in a specific list
+ * @brief Finds the membership of an user
+ * @return NULL if the user is neither in the channel nor invited
  */
-User	*Channel::findUserFromList(std::list<User *> &role, std::string nickname)
+s_membership	*Channel::findMember(User *user)
 {
-	user_iterator it;
-	for (it = role.begin(); it != role.end(); it++){
-		if((*it)->getNickname() == nickname)
-			return (*it);
+	s_membership	**member = _memberIndex.find(user);
+
+	if (member == NULL)
+		return (NULL);
+	return (*member);
+}
+
+/**
+ * @brief Sets status bits of an user, links it to the channel if needed (see User::attach())
+ */
+void	Channel::addStatus(User *user, memberStatus status)
+{
+	s_membership	*member = findMember(user);
+
+	if (member == NULL)
+	{
+		member = new s_membership;
+		member->user = user;
+		member->channel = this;
+		member->status = 0;
+		member->channelSlot = _members.size();
+		_members.push_back(member);
+		_memberIndex.insert(user, member);
+		user->attach(member);
 	}
-	return NULL;
+	status &= ~member->status;
+	if ((status & MEMBER_JOINED) && user->isRemote())
+		_server->trackRemoteMember(user, _channelName, true);
+	if (status & MEMBER_JOINED)
+		_nbOfJoined++;
+	if (status & MEMBER_OPERATOR)
+		_nbOfOperators++;
+	member->status |= status;
+}
+
+/**
+ * @brief Clears status bits of an user, it is unlinked when none is left
+ */
+void	Channel::removeStatus(User *user, memberStatus status)
+{
+	s_membership	*member = findMember(user);
+
+	if (member == NULL)
+		return ;
+	status &= member->status;
+	if ((status & MEMBER_JOINED) && user->isRemote())
+		_server->trackRemoteMember(user, _channelName, false);
+	if (status & MEMBER_JOINED)
+		_nbOfJoined--;
+	if (status & MEMBER_OPERATOR)
+		_nbOfOperators--;
+	member->status &= ~status;
+	if (member->status == 0)
+		dropMember(member);
+}
+
+/**
+ * @brief Unlinks a membership from both sides and frees it
+ * @note The last member takes its place: the table stays packed.
+ */
+void	Channel::dropMember(s_membership *member)
+{
+	s_membership	*last = _members.back();
+
+	_members[member->channelSlot] = last;
+	last->channelSlot = member->channelSlot;
+	_members.pop_back();
+	_memberIndex.erase(member->user);
+	member->user->detach(member);
+	delete member;
 }
 
 /**
@@ -270,14 +331,19 @@ User	*Channel::findUserFromList(std::list<User *> &role, std::string nickname)
  */
 bool	Channel::isChannelEmpty()
 {
-	if (_operators.size() + _normalUsers.size() == 0)
+	if (_nbOfJoined == 0)
 		return (true);
 
-	User	*user;
-	if (_operators.size() == 0)
+	if (_nbOfOperators == 0)
 	{
-		user = _normalUsers.front();
-		setUserLevel(user, OPERATOR);
+		for (std::vector<s_membership *>::iterator it = _members.begin(); it != _members.end(); it++)
+		{
+			if ((*it)->status & MEMBER_JOINED)
+			{
+				setUserLevel((*it)->user, OPERATOR);
+				break ;
+			}
+		}
 	}
 	return (false);
 }
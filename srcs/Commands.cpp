@@ -2,79 +2,167 @@
 
 /* #region EXTERNAL FUNCTIONS */
 
+// dispatch table: name (as sent in replies) and checks of every command
+static s_cmdEntry const	g_cmdTable[CMD_COUNT] =
+{
+	{"", CMD_SHARED},								// CMD_UNKNOWN
+	{"QUIT", 0},
+	{"PASS", 0},
+	{"NICK", 0},
+	{"USER", 0},
+	{"PING", CMD_REGISTERED | CMD_SHARED},
+	{"PONG", CMD_SHARED},
+	{"JOIN", CMD_REGISTERED},
+	{"PART", CMD_REGISTERED},
+	{"KICK", CMD_REGISTERED},
+	{"INVITE", CMD_REGISTERED},
+	{"PRIVMSG", CMD_REGISTERED | CMD_SHARED},
+	{"TOPIC", CMD_REGISTERED},
+	{"MODE", CMD_REGISTERED},
+	{"OPER", CMD_REGISTERED},
+	{"POWEROFF", CMD_REGISTERED | CMD_SERVER_OP},
+	{"CAP", CMD_SHARED}								// ignored, no handler
+};
+
+// perfect hash slots: no two names of g_cmdTable share a slot (see commandHash()),
+// regenerated by hand when a command is added: test_commands checks it before
+// the server is linked (see the Makefile), initCommands() at startup
+static e_cmdId const	g_cmdSlots[CMD_SLOTS] =
+{
+	CMD_UNKNOWN, CMD_UNKNOWN, CMD_QUIT, CMD_CAP,
+	CMD_PING, CMD_UNKNOWN, CMD_INVITE, CMD_UNKNOWN,
+	CMD_PASS, CMD_PART, CMD_PONG, CMD_UNKNOWN,
+	CMD_UNKNOWN, CMD_POWEROFF, CMD_UNKNOWN, CMD_KICK,
+	CMD_PRIVMSG, CMD_OPER, CMD_USER, CMD_JOIN,
+	CMD_UNKNOWN, CMD_UNKNOWN, CMD_UNKNOWN, CMD_UNKNOWN,
+	CMD_UNKNOWN, CMD_MODE, CMD_UNKNOWN, CMD_TOPIC,
+	CMD_UNKNOWN, CMD_UNKNOWN, CMD_NICK, CMD_UNKNOWN
+};
+
+static char	fold(char c) { return (std::toupper(static_cast<unsigned char>(c))); }
+
+/**
+ * @brief Slot of a command name: length, first, second and last chars (case-insensitive)
+ */
+static size_t	commandHash(char const *name, size_t len)
+{
+	return ((len + fold(name[0]) * 5 + fold(name[1]) + fold(name[len - 1])) & (CMD_SLOTS - 1));
+}
+
+/**
+ * @brief Resolves a command name, whatever its case, without any string allocation
+ *
+ * @return CMD_UNKNOWN if it isn't a command of the server
+ * @note The name in the slot is compared as only known names have a reserved slot.
+ */
+e_cmdId	commandId(char const *name, size_t len)
+{
+	if (len < 2)
+		return (CMD_UNKNOWN);
+
+	e_cmdId		id = g_cmdSlots[commandHash(name, len)];
+	char const	*expected = g_cmdTable[id].name;
+
+	for (size_t i = 0; i < len; i++)
+	{
+		if (expected[i] == '\0' || fold(name[i]) != expected[i])
+			return (CMD_UNKNOWN);
+	}
+	return (expected[len] == '\0' ? id : CMD_UNKNOWN);
+}
+
+/**
+ * @brief Name of the command as sent in replies, "" for CMD_UNKNOWN
+ */
+char const	*commandName(e_cmdId id)
+{
+	return (g_cmdTable[id].name);
+}
+
+/**
+ * @brief Whether the command can run while other shared ones do (see ServerLock): it only
+ * reads Users and Channels, its replies go to SendQs, which have their own lock
+ * @note Commands changing a client or a channel (NICK, JOIN, MODE...) need the exclusive lock.
+ */
+bool	isSharedCommand(e_cmdId id)
+{
+	return (g_cmdTable[id].flags & CMD_SHARED);
+}
+
 /**
  * @brief Initialises the given command list with all commands that are available
+ *
+ * @throw std::logic_error if a name of g_cmdTable isn't resolved to its own command
+ * (g_cmdSlots not regenerated after a command was added)
  */
-void	initCommands(Server *server, std::map<std::string, Command *> &commands)
+void	initCommands(Server *server, Command *commands[CMD_COUNT])
 {
-	commands["QUIT"] = new Quit(server);
-	commands["PASS"] = new Pass(server);
-	commands["NICK"] = new Nick(server);
-	commands["USER"] = new UserCMD(server);
-	commands["PING"] = new Ping(server);		//REGISTRATION NEEDED
-	commands["JOIN"] = new Join(server);		//REGISTRATION NEEDED
-	commands["PART"] = new Part(server);		//REGISTRATION NEEDED
-	commands["KICK"] = new Kick(server);		//REGISTRATION NEEDED
-	commands["INVITE"] = new Invite(server);	//REGISTRATION NEEDED
-	commands["PRIVMSG"] = new Privmsg(server);	//REGISTRATION NEEDED
-	commands["TOPIC"] = new Topic(server);		//REGISTRATION NEEDED
-	commands["MODE"] = new Mode(server);		//REGISTRATION NEEDED
-	commands["OPER"] = new Oper(server);		//REGISTRATION NEEDED
-	commands["POWEROFF"] = new Poweroff(server);//SERVER OPERATOR ONLY
+	for (int id = CMD_UNKNOWN + 1; id < CMD_COUNT; id++)
+	{
+		char const	*name = g_cmdTable[id].name;
+
+		if (commandId(name, strlen(name)) != id)
+			throw std::logic_error("command " + std::string(name) + " has no slot in g_cmdSlots");
+	}
+	for (int id = 0; id < CMD_COUNT; id++)
+		commands[id] = NULL;
+	commands[CMD_QUIT] = new Quit(server);
+	commands[CMD_PASS] = new Pass(server);
+	commands[CMD_NICK] = new Nick(server);
+	commands[CMD_USER] = new UserCMD(server);
+	commands[CMD_PING] = new Ping(server);
+	commands[CMD_PONG] = new Pong(server);
+	commands[CMD_JOIN] = new Join(server);
+	commands[CMD_PART] = new Part(server);
+	commands[CMD_KICK] = new Kick(server);
+	commands[CMD_INVITE] = new Invite(server);
+	commands[CMD_PRIVMSG] = new Privmsg(server);
+	commands[CMD_TOPIC] = new Topic(server);
+	commands[CMD_MODE] = new Mode(server);
+	commands[CMD_OPER] = new Oper(server);
+	commands[CMD_POWEROFF] = new Poweroff(server);
 }
 
 /**
- * @brief Redirects to all different Commands
+ * @brief Redirects to all different Commands, once the checks of the dispatch table passed
  */
 void	execute(Server	*server, User *user, s_msg &msg)
 {
-	if (msg.cmd == "QUIT")
-		(*server->getCommands()["QUIT"]).execute(user, msg);
-	else if (msg.cmd == "PASS")
-		(*server->getCommands()["PASS"]).execute(user, msg);
-	else if (msg.cmd == "NICK")
-		(*server->getCommands()["NICK"]).execute(user, msg);
-	else if (msg.cmd == "USER")
-		(*server->getCommands()["USER"]).execute(user, msg);
-	else if (msg.cmd == "PING")
-		(*server->getCommands()["PING"]).execute(user, msg);
-	else if (msg.cmd == "JOIN")
-		(*server->getCommands()["JOIN"]).execute(user, msg);
-	else if (msg.cmd == "PART")
-		(*server->getCommands()["PART"]).execute(user, msg);
-	else if (msg.cmd == "KICK")
-		(*server->getCommands()["KICK"]).execute(user, msg);
-	else if (msg.cmd == "INVITE")
-		(*server->getCommands()["INVITE"]).execute(user, msg);
-	else if (msg.cmd == "PRIVMSG")
-		(*server->getCommands()["PRIVMSG"]).execute(user, msg);
-	else if (msg.cmd == "TOPIC")
-		(*server->getCommands()["TOPIC"]).execute(user, msg);
-	else if (msg.cmd == "MODE")
-		(*server->getCommands()["MODE"]).execute(user, msg);
-	else if (msg.cmd == "OPER")
-		(*server->getCommands()["OPER"]).execute(user, msg);
-	else if (msg.cmd == "POWEROFF")
-		(*server->getCommands()["POWEROFF"]).execute(user, msg);
-	else if (msg.cmd == "CAP")
-		;	// Just ignore CAP request
-	else
+	s_cmdEntry const	&entry = g_cmdTable[msg.cmdId];
+	Command				*command = server->getCommand(msg.cmdId);
+
+	if (msg.cmdId == CMD_UNKNOWN)
 		user->sendToClient(ERR_UNKNOWNCOMMAND(user->getNickname(), msg.cmd));
+	else if ((entry.flags & CMD_REGISTERED) && user->getStatus() != REGISTERED)
+		user->sendToClient(ERR_NOTREGISTERED(user->getNickname(), entry.name));
+	else if ((entry.flags & CMD_SERVER_OP) && !user->isServerOp())
+		user->sendToClient(ERR_NOPRIVILEGES(user->getNickname()));
+	else if (command != NULL)
+		command->execute(user, msg);
 }
 
 /**
- * @brief Cleans the given command list
+ * @brief Line of a command, rendered again to be forwarded to another worker process
+ * (see Server::forward())
  */
-void	deleteCommands(std::map<std::string, Command *> &commands)
+static std::string	toLine(s_msg const &msg)
 {
-	std::map<std::string, Command *>::iterator it = commands.begin();
-	std::map<std::string, Command *>::iterator end = commands.end();
+	std::string	line(g_cmdTable[msg.cmdId].name);
 
-	while (it != end)
-	{
-		delete it->second;
-		it++;
-	}
+	for (size_t i = 0; i < msg.args.size(); i++)
+		line.append(" ").append(msg.args[i].data(), msg.args[i].size());
+	if (msg.trailing_sign)
+		line.append(" :").append(msg.trailing.data(), msg.trailing.size());
+	return (line);
+}
+
+/**
+ * @brief Cleans the given command list
+ */
+void	deleteCommands(Command *commands[CMD_COUNT])
+{
+	for (int id = 0; id < CMD_COUNT; id++)
+		delete commands[id];
 }
 /* #endregion */
 
@@ -139,6 +227,18 @@ static bool	isNickValid(std::string const &nick)
 	return (true);
 }
 
+/**
+ * @brief Whether no other client has the nickname, in any case (see Server::getUserWithNickname()),
+ * nor is waiting for it (see Server::claimNickname())
+ */
+static bool	isNickFree(Server *server, User *user, std::string const &nick)
+{
+	User	*owner = server->getUserWithNickname(nick);
+	User	*claimant = server->getClaimant(nick);
+
+	return ((owner == NULL || owner == user) && (claimant == NULL || claimant == user));
+}
+
 Nick::Nick(Server* server) : Command(server) {  }
 Nick::~Nick() {  }
 
@@ -153,32 +253,44 @@ void	Nick::execute(User *user, s_msg &msg)
 		if (!isNickValid(msg.args[0]))
 			user->sendToClient(ERR_ERRONEUSNICKNAME(user->getNickname(), msg.args[0]));
 
-		// Nickname already in use
-		else if (_server->getUserWithNickname(msg.args[0]))
+		// Nickname already in use (here, or in another worker process), in any case:
+		// the client can only change the case of its own
+		else if (!isNickFree(_server, user, msg.args[0]) || !_server->claimNickname(user, msg.args[0]))
 			user->sendToClient(ERR_NICKNAMEINUSE(user->getNickname(), msg.args[0]));
-		
-		// Nickname is accepted
-		else
+
+		// Nickname is accepted, unless the other worker processes are asked first:
+		// the Supervisor's answer ends the command (see Server::endClaim())
+		else if (!user->isWaiting())
+			answer(user, msg.args[0], true);
+	}
+}
+
+/**
+ * @brief End of a NICK: the nickname is taken, or refused if another worker process has it
+ */
+void	Nick::answer(User *user, std::string const &nickname, bool isFree)
+{
+	if (!isFree)
+		user->sendToClient(ERR_NICKNAMEINUSE(user->getNickname(), nickname));
+	else
+	{
+		if (user->getStatus() == PASSWORDACCEPTED)
 		{
-			if (user->getStatus() == PASSWORDACCEPTED)
-			{
-				user->setNickname(msg.args[0]);
-				user->setStatus(NICKNAMEISOK);
-			}
-			else if (user->getStatus() == USERNAMEISOK)
-			{
-				user->setNickname(msg.args[0]);
-				user->setStatus(REGISTERED);
-				user->welcome();
-			}
-			else if (user->getStatus() == NICKNAMEISOK || user->getStatus() == REGISTERED) 
-			{
-				if (user->getStatus() == REGISTERED)
-					user->sendToClient(SEND_NICK(user->getFullname(), msg.args[0]));
-				user->setNickname(msg.args[0]);
-			}
-			msg_log(MSG_CLT_NICK(user->getSocketFd(), user->getNickname()));
+			user->setNickname(nickname);
+			user->setStatus(NICKNAMEISOK);
+		}
+		else if (user->getStatus() == USERNAMEISOK)
+		{
+			user->setNickname(nickname);
+			user->completeRegistration();
+		}
+		else if (user->getStatus() == NICKNAMEISOK || user->getStatus() == REGISTERED) 
+		{
+			if (user->getStatus() == REGISTERED)
+				user->sendToClient(SEND_NICK(user->getFullname(), nickname));
+			user->setNickname(nickname);
 		}
+		msg_log(MSG_CLT_NICK, user->getSocketFd(), user->getNickname());
 	}
 }
 /* #endregion */
@@ -250,8 +362,7 @@ void	UserCMD::execute(User *user, s_msg &msg)
 		{
 			user->setUsername(msg.args[0]);
 			user->setRealname(msg.trailing);
-			user->setStatus(REGISTERED);
-			user->welcome();
+			user->completeRegistration();
 		}
 		else if (user->getStatus() == USERNAMEISOK)
 		{
@@ -270,12 +381,8 @@ Ping::~Ping() {  }
 
 void	Ping::execute(User *user, s_msg &msg)
 {
-	// User is not registered
-	if (user->getStatus() != REGISTERED)
-		user->sendToClient(ERR_NOTREGISTERED(user->getNickname(), "PING"));
-
 	// No arg given
-	else if (msg.args.empty())
+	if (msg.args.empty())
 		user->sendToClient(ERR_NOORIGIN(user->getNickname()));
 
 	// Default PING response
@@ -284,6 +391,23 @@ void	Ping::execute(User *user, s_msg &msg)
 }
 /* #endregion */
 
+/* #region PONG */
+
+Pong::Pong(Server *server): Command(server) {   }
+Pong::~Pong() {  }
+
+/**
+ * @brief Answer to the keepalive PING, accepted at any time
+ * @note The client's Reactor already counted the line as activity (see Reactor::handleTimeout()).
+ */
+void	Pong::execute(User *user, s_msg &msg)
+{
+	// No arg given
+	if (msg.args.empty() && msg.trailing.empty())
+		user->sendToClient(ERR_NOORIGIN(user->getNickname()));
+}
+/* #endregion */
+
 /* #region JOIN */
 
 static bool	isChanNameValid(std::string const &name)
@@ -307,10 +431,10 @@ static bool	isChanNameValid(std::string const &name)
 	return (true);
 }
 
-static void	parseJoin(std::vector<std::string> &chan_list, std::vector<std::string> &key_list, std::vector<std::string> const &args)
+static void	parseJoin(std::vector<std::string> &chan_list, std::vector<std::string> &key_list, Params const &args)
 {
 	// get every channel in the 1st argument
-	std::istringstream iss_chan(args[0]);
+	std::istringstream iss_chan(args[0].str());
 	std::string chan;
 	while (std::getline(iss_chan, chan, ','))
 		chan_list.push_back(chan);
@@ -320,7 +444,7 @@ static void	parseJoin(std::vector<std::string> &chan_list, std::vector<std::stri
 		return ;
 
 	// get every key in the 2nd argument
-	std::istringstream iss_key(args[1]);
+	std::istringstream iss_key(args[1].str());
 	std::string key;
 	while (std::getline(iss_key, key, ','))
 		key_list.push_back(key);
@@ -331,17 +455,16 @@ Join::~Join() {  }
 
 void	Join::execute(User *user, s_msg &msg)
 {
-	// User is not registered
-	if (user->getStatus() != REGISTERED)
-		user->sendToClient(ERR_NOTREGISTERED(user->getNickname(), "JOIN"));
-
 	// No argument given
-	else if (msg.args.empty())
+	if (msg.args.empty())
 		user->sendToClient(ERR_NEEDMOREPARAMS(user->getNickname(), "JOIN"));
 
-	// JOIN 0 means PART from all channels
+	// JOIN 0 means PART from all channels (the ones of the other worker processes too)
 	else if (msg.args[0] == "0")
+	{
+		_server->forwardToAll(user, "JOIN 0");
 		user->leaveAllChannels("PART");
+	}
 
 	else
 	{
@@ -356,6 +479,18 @@ void	Join::execute(User *user, s_msg &msg)
 			if (!isChanNameValid(*it))
 				user->sendToClient(ERR_BADCHANNAME(user->getNickname(), *it));
 
+			// Channel of another worker process: it checks the key given with it
+			else if (_server->mustForward(user, *it))
+			{
+				if (key_list.empty())
+					_server->forward(user, *it, "JOIN " + *it);
+				else
+				{
+					_server->forward(user, *it, "JOIN " + *it + " " + key_list.front());
+					key_list.erase(key_list.begin());
+				}
+			}
+
 			else
 			{
 				Channel *channel = _server->findChannel(*it);
@@ -364,7 +499,7 @@ void	Join::execute(User *user, s_msg &msg)
 				if (channel)
 				{
 					// User already in channel -> just ignore
-					if (channel->findUserInChannel(user->getNickname()))
+					if (channel->isMember(user))
 						(void)user;
 
 					// Channel is full (+l)
@@ -372,7 +507,7 @@ void	Join::execute(User *user, s_msg &msg)
 						user->sendToClient(ERR_CHANNELISFULL(user->getNickname(), channel->getChannelName()));
 
 					// Channel needs invitation and not invited
-					else if (channel->isMode(INVITE_ONLY) && !channel->isInvited(user->getNickname()))
+					else if (channel->isMode(INVITE_ONLY) && !channel->isInvited(user))
 						user->sendToClient(ERR_INVITEONLYCHAN(user->getNickname(), channel->getChannelName()));
 
 					else
@@ -444,12 +579,8 @@ Part::~Part() {  }
 
 void	Part::execute(User *user, s_msg &msg)
 {
-	// User is not registered
-	if (user->getStatus() != REGISTERED)
-		user->sendToClient(ERR_NOTREGISTERED(user->getNickname(), "PART"));
-
 	// No parameters given
-	else if (msg.args.empty())
+	if (msg.args.empty())
 			user->sendToClient(ERR_NEEDMOREPARAMS(user->getNickname(), "PART"));
 
 	else
@@ -461,6 +592,16 @@ void	Part::execute(User *user, s_msg &msg)
 		// Run through every channel
 		for (std::vector<std::string>::iterator it = chan_list.begin(); it != chan_list.end(); it++)
 		{
+			// Channel of another worker process
+			if (_server->mustForward(user, *it))
+			{
+				if (msg.trailing.empty())
+					_server->forward(user, *it, "PART " + *it);
+				else
+					_server->forward(user, *it, "PART " + *it + " :" + msg.trailing);
+				continue ;
+			}
+
 			Channel	*channel = _server->findChannel(*it);
 
 			// Channel doesn't exist
@@ -468,7 +609,7 @@ void	Part::execute(User *user, s_msg &msg)
 				user->sendToClient(ERR_NOSUCHCHANNEL(user->getNickname(), *it));
 
 			// User not in the channel
-			else if (!channel->findUserInChannel(user->getNickname()))
+			else if (!channel->isMember(user))
 				user->sendToClient(ERR_NOTONCHANNEL(user->getNickname(), channel->getChannelName()));
 
 			// Part is allowed
@@ -485,17 +626,17 @@ void	Part::execute(User *user, s_msg &msg)
 
 /* #region KICK */
 
-static void	parseKick(std::vector<std::string> &chan_list, std::vector<std::string> &user_list, std::vector<std::string> const &args)
+static void	parseKick(std::vector<std::string> &chan_list, std::vector<std::string> &user_list, Params const &args)
 {
 	// get every channel in the 1st argument
-	std::istringstream iss_chan(args[0]);
+	std::istringstream iss_chan(args[0].str());
 	std::string chan;
 	while (std::getline(iss_chan, chan, ','))
 		chan_list.push_back(chan);
 	
 
 	// get every user in the 2nd argument
-	std::istringstream iss_user(args[1]);
+	std::istringstream iss_user(args[1].str());
 	std::string user;
 	while (std::getline(iss_user, user, ','))
 		user_list.push_back(user);
@@ -506,12 +647,8 @@ Kick::~Kick() {  }
 
 void	Kick::execute(User *user, s_msg &msg)
 {
-	// User is not registered
-	if (user->getStatus() != REGISTERED)
-		user->sendToClient(ERR_NOTREGISTERED(user->getNickname(), "KICK"));
-
 	// Not enough params
-	else if (msg.args.empty() || msg.args.size() != 2)
+	if (msg.args.empty() || msg.args.size() != 2)
 		user->sendToClient(ERR_NEEDMOREPARAMS(user->getNickname(), "KICK"));
 	else
 	{
@@ -523,6 +660,13 @@ void	Kick::execute(User *user, s_msg &msg)
 		// Run through every channel
 		for (std::vector<std::string>::iterator it = chan_list.begin(); it != chan_list.end(); it++)
 		{
+			// Channel of another worker process
+			if (_server->mustForward(user, *it))
+			{
+				_server->forward(user, *it, "KICK " + *it + " " + msg.args[1] + " :" + msg.trailing);
+				continue ;
+			}
+
 			Channel	*channel = _server->findChannel(*it);
 
 			// Channel is invalid
@@ -533,11 +677,11 @@ void	Kick::execute(User *user, s_msg &msg)
 			else
 			{
 				// Kick launcher not in channel
-				if (!channel->findUserInChannel(user->getNickname())) 
+				if (!channel->isMember(user))
 					user->sendToClient(ERR_NOTONCHANNEL(user->getNickname(), channel->getChannelName()));
 
 				// Kick launcher not operator
-				else if (!channel->isOperator(user->getNickname()))
+				else if (!channel->isOperator(user))
 						user->sendToClient(ERR_CHANOPRIVSNEEDED(user->getNickname(), channel->getChannelName()));
 				
 				// Kick launcher is allowed to KICK 
@@ -553,7 +697,7 @@ void	Kick::execute(User *user, s_msg &msg)
 							user->sendToClient(ERR_NOSUCHNICK(user->getNickname(), *it2));
 
 						// Target not in the channel
-						else if (!channel->findUserInChannel(target->getNickname()))
+						else if (!channel->isMember(target))
 							user->sendToClient(ERR_USERNOTINCHANNEL(user->getNickname(), target->getNickname(), channel->getChannelName()));
 
 						// Kick
@@ -590,36 +734,39 @@ Invite::~Invite() {  }
  */
 void	Invite::execute(User *user, s_msg &msg)
 {
-	// User is not registered
-	if (user->getStatus() != REGISTERED)
-		user->sendToClient(ERR_NOTREGISTERED(user->getNickname(), "INVITE"));
-
 	// Not enough arguments given
-	else if (msg.args.empty())
+	if (msg.args.empty())
 		user->sendToClient(ERR_NEEDMOREPARAMS(user->getNickname(), "INVITE"));
 
 	// Too much arguments given
 	else if (msg.args.size() != 2)
 		user->sendToClient(ERR_SYNTAX(user->getNickname(), "INVITE"));
 
+	// Channel of another worker process
+	else if (_server->mustForward(user, msg.args[1]))
+		_server->forward(user, msg.args[1], toLine(msg));
+
 	// Syntax Correct
 	else
 	{
-		User	*target = _server->getUserWithNickname(msg.args[0]);
 		Channel	*channel = _server->findChannel(msg.args[1]);
+		User	*target = _server->getUserWithNickname(msg.args[0]);
 
-		// target user doesn't exist
-		if (target == NULL)
+		// target user doesn't exist, here nor in another worker
+		if (target == NULL && _server->getRemoteNickname(msg.args[0]) == NULL)
 			user->sendToClient(ERR_NOSUCHNICK(user->getNickname(), msg.args[0]));
 
 		// channel doesn't exist
-		else if (channel == NULL || channel->isInvited(user->getNickname()))
+		else if (channel == NULL || channel->isInvited(user))
 			return ;
 
 		// Target is not already on channel -> invite it
 		// check if already invited is done in inviteUser().
-		else if (channel->findUserInChannel(target->getNickname()) == NULL)
+		// A client of another worker is only added here now, to keep its invitation.
+		else if (target == NULL || !channel->isMember(target))
 		{
+			if (target == NULL)
+				target = _server->findUser(msg.args[0]);
 			channel->addUser(target, INVITED);
 			target->sendToClient(SEND_INVIT(user->getFullname(), user->getNickname(), channel->getChannelName()));
 			user->sendToClient(RPL_INVITING(user->getNickname(), target->getNickname(), channel->getChannelName()));
@@ -648,12 +795,8 @@ Privmsg::~Privmsg() {  }
 
 void	Privmsg::execute(User *user, s_msg &msg)
 {
-	// user is not registered
-	if (user->getStatus() != REGISTERED)	
-		user->sendToClient(ERR_NOTREGISTERED(user->getNickname(), "PRIVMSG"));
-	
 	// no argument given
-	else if (msg.args.empty())
+	if (msg.args.empty())
 		user->sendToClient(ERR_NORECIPIENT(user->getNickname()));
 	
 	// no message given (trailing)
@@ -688,12 +831,16 @@ void	Privmsg::execute(User *user, s_msg &msg)
 				{
 					Channel	*channel = _server->findChannel(recipient);
 			
+					// Channel of another worker process
+					if (_server->mustForward(user, recipient))
+						_server->forward(user, recipient, "PRIVMSG " + recipient + " :" + msg.trailing);
+
 					// Channel doesn't exists
-					if (channel == NULL)
+					else if (channel == NULL)
 						user->sendToClient(ERR_NOSUCHCHANNEL(user->getNickname(), recipient));
 					
 					// User is not in channel
-					else if (!channel->findUserInChannel(user->getNickname()))
+					else if (!channel->isMember(user))
 						user->sendToClient(ERR_CANNOTSENDTOCHAN(user->getNickname(), recipient));
 					
 					// Send to channel
@@ -704,11 +851,18 @@ void	Privmsg::execute(User *user, s_msg &msg)
 				// Recipient is an user
 				else
 				{
-					User	*target = _server->getUserWithNickname(recipient);
+					User				*target = _server->getUserWithNickname(recipient);
+					std::string const	*remoteNickname = NULL;
 
-					// target doesn't exist
+					// target isn't here: it may be a client of another worker process (named as it chose), or doesn't exist
 					if (target == NULL)
-						user->sendToClient(ERR_NOSUCHNICK(user->getNickname(), recipient));
+					{
+						remoteNickname = _server->getRemoteNickname(recipient);
+						if (remoteNickname == NULL)
+							user->sendToClient(ERR_NOSUCHNICK(user->getNickname(), recipient));
+						else
+							_server->sendToRemoteUser(*remoteNickname, SEND_PM(user->getFullname(), *remoteNickname, msg.trailing));
+					}
 
 					// send to target
 					else
@@ -729,18 +883,18 @@ Topic::~Topic() {  }
 
 void	Topic::execute(User *user, s_msg &msg)
 {
-	// User is not registered
-	if (user->getStatus() != REGISTERED)
-		user->sendToClient(ERR_NOTREGISTERED(user->getNickname(), "TOPIC"));
-
 	// No arguments given nor trailing
-	else if (msg.args.empty() && msg.trailing.empty())
+	if (msg.args.empty() && msg.trailing.empty())
 		user->sendToClient(ERR_NEEDMOREPARAMS(user->getNickname(), "TOPIC"));
 
 	// No arguments given but a trailing
 	else if (msg.args.empty() && !msg.trailing.empty())
 		user->sendToClient(ERR_NOSUCHCHANNEL(user->getNickname(), ":" + msg.trailing));
 
+	// Channel of another worker process
+	else if (_server->mustForward(user, msg.args[0]))
+		_server->forward(user, msg.args[0], toLine(msg));
+
 	// arguments given
 	else
 	{
@@ -755,14 +909,14 @@ void	Topic::execute(User *user, s_msg &msg)
 			user->sendToClient(channel->sendTopic(user));
 
 		// User not in Channel and args or trailing
-		else if (!channel->findUserInChannel(user->getNickname()) )
+		else if (!channel->isMember(user))
 			user->sendToClient(ERR_NOTONCHANNEL(user->getNickname(), channel->getChannelName()));
 
 		// User is in channel
 		else
 		{
 			// User is not operator and channel is mode +t
-			if (channel->isMode(TOPIC) && !channel->isOperator(user->getNickname()))
+			if (channel->isMode(TOPIC) && !channel->isOperator(user))
 				user->sendToClient(ERR_CHANOPRIVSNEEDED(user->getNickname(), channel->getChannelName()));
 
 			// User operator OR channel is not mode +t
@@ -825,12 +979,12 @@ static modeVal	c_to_val(char c)
 /* #endregion */
 
 /* #region Constructor / Destructor */
-Mode::Mode(Server *server): Command(server) { _last = PLUS; }
+Mode::Mode(Server *server): Command(server) {  }
 Mode::~Mode() {  }
 /* #endregion */
 
 /* #region Parsing */
-static std::string	parseMode(std::queue<std::pair<char, modePair> > &mods, std::queue<std::string> &params, std::vector<std::string> &args)
+static std::string	parseMode(std::queue<std::pair<char, modePair> > &mods, std::queue<std::string> &params, Params const &args)
 {
 	// If no + or - given, server considers it as a +
 	modeType	last = PLUS;
@@ -843,9 +997,9 @@ static std::string	parseMode(std::queue<std::pair<char, modePair> > &mods, std::
 		return target;
 
 	// For args[1], get every char to convert into modePair and store both
-	for (std::string::iterator it = args[1].begin(); it != args[1].end(); ++it)
+	for (size_t i = 0; i < args[1].size(); ++i)
 	{
-		char	c = *it;
+		char	c = args[1][i];
 		if (c == '+')
 			last = PLUS;
 		else if (c == '-')
@@ -879,13 +1033,13 @@ void	Mode::execute(User *user, s_msg &msg)
 {
 
 	/* #region Basic errors */
-	// user is not registered
-	if (user->getStatus() != REGISTERED)
-		user->sendToClient(ERR_NOTREGISTERED(user->getNickname(), "MODE"));
-
 	// no param given
-	else if (msg.args.empty())
+	if (msg.args.empty())
 	user->sendToClient(ERR_NEEDMOREPARAMS(user->getNickname(), "MODE"));
+
+	// channel of another worker process
+	else if ((msg.args[0][0] == '#' || msg.args[0][0] == '&') && _server->mustForward(user, msg.args[0]))
+		_server->forward(user, msg.args[0], toLine(msg));
 	/* #endregion */
 
 	else
@@ -894,23 +1048,26 @@ void	Mode::execute(User *user, s_msg &msg)
 		std::queue<std::string>						params;
 		std::string									target = parseMode(mods, params, msg.args);
 		Channel										*channel = _server->findChannel(target);
+		User										*targetUser = _server->getUserWithNickname(target);
 
-		_modsToSend.clear();
-		_paramsToSend.clear();
+		// reply state is local: the same Command object may run in several threads
+		modeType									last = PLUS;
+		std::string									modsToSend;
+		std::string									paramsToSend;
 
 	/* #region Target incorrect */
-		// if target is an existing OTHER user
-		if (target != user->getNickname() && _server->getUserWithNickname(target) != NULL)
+		// if target is an existing OTHER user, here or in another worker (nicknames are compared in any case)
+		if ((targetUser != NULL && targetUser != user) || (targetUser == NULL && _server->getRemoteNickname(target)))
 			user->sendToClient(ERR_USERSDONTMATCH(user->getNickname()));
 
 		// if target is not a channel nor an existing user
-		else if (_server->getUserWithNickname(target) == NULL && !channel)
+		else if (targetUser == NULL && !channel)
 			user->sendToClient(ERR_NOSUCHCHANNEL(user->getNickname(), target));
 	/* #endregion */
 
 	/* #region Target is himself */
 		// if target is the user himself
-		else if (target == user->getNickname())
+		else if (targetUser == user)
 		{
 			// no mods -> show user's modes
 			if (mods.empty())
@@ -965,7 +1122,7 @@ void	Mode::execute(User *user, s_msg &msg)
 			if (mods.empty())
 			{
 				// client is a member of the channel
-				if (channel->findUserInChannel(user->getNickname()) != NULL)
+				if (channel->isMember(user))
 					user->sendToClient(RPL_CHANNELMODEIS(user->getNickname(), channel->getChannelName(), channel->listModes(true)));
 				else
 					user->sendToClient(RPL_CHANNELMODEIS(user->getNickname(), channel->getChannelName(), channel->listModes(false)));
@@ -974,7 +1131,7 @@ void	Mode::execute(User *user, s_msg &msg)
 
 		/* #region User not OP */
 			// user is not OP
-			else if (!channel->isOperator(user->getNickname()))
+			else if (!channel->isOperator(user))
 				user->sendToClient(ERR_CHANOPRIVSNEEDED(user->getNickname(), channel->getChannelName()));
 		/* #endregion */
 
@@ -1006,12 +1163,12 @@ void	Mode::execute(User *user, s_msg &msg)
 						happened[I_MODE] = true;
 
 						// fill the modes to send
-						if (_last != mp.first || _modsToSend.empty())
+						if (last != mp.first || modsToSend.empty())
 						{
-							_last = mp.first;
-							_modsToSend += type_to_c(_last);
+							last = mp.first;
+							modsToSend += type_to_c(last);
 						}
-						_modsToSend += 'i';
+						modsToSend += 'i';
 					}
 				/* #endregion */
 
@@ -1023,22 +1180,22 @@ void	Mode::execute(User *user, s_msg &msg)
 						if (mp.first == PLUS)
 						{
 							channel->setPassword(params.front());
-							if (!_paramsToSend.empty())
-								_paramsToSend += " ";
-							_paramsToSend += params.front();
+							if (!paramsToSend.empty())
+								paramsToSend += " ";
+							paramsToSend += params.front();
 						}
 						// -k
 						else
 						{
-							if (!_paramsToSend.empty())
-								_paramsToSend += " ";
+							if (!paramsToSend.empty())
+								paramsToSend += " ";
 
 							// channel had a password
 							if (channel->isMode(KEY))
-								_paramsToSend += channel->getPassword();
+								paramsToSend += channel->getPassword();
 							// channel had no password;
 							else
-								_paramsToSend += params.front();
+								paramsToSend += params.front();
 							channel->setPassword("");
 						}
 
@@ -1046,12 +1203,12 @@ void	Mode::execute(User *user, s_msg &msg)
 						channel->setMode(KEY, mp.first);
 						happened[K_MODE] = true;
 
-						if (_last != mp.first || _modsToSend.empty())
+						if (last != mp.first || modsToSend.empty())
 						{
-							_last = mp.first;
-							_modsToSend += type_to_c(_last);
+							last = mp.first;
+							modsToSend += type_to_c(last);
 						}
-						_modsToSend += 'k';
+						modsToSend += 'k';
 
 						// delete first parameter
 						params.pop();
@@ -1071,12 +1228,12 @@ void	Mode::execute(User *user, s_msg &msg)
 						{
 							channel->setMaxUsers(0);
 							channel->setMode(LIMIT, MINUS);
-							if (_last != mp.first || _modsToSend.empty())
+							if (last != mp.first || modsToSend.empty())
 							{
-								_last = mp.first;
-								_modsToSend += type_to_c(_last);
+								last = mp.first;
+								modsToSend += type_to_c(last);
 							}
-							_modsToSend += 'l';
+							modsToSend += 'l';
 						}
 						// params given
 						else
@@ -1096,20 +1253,20 @@ void	Mode::execute(User *user, s_msg &msg)
 								{
 									channel->setMaxUsers(max);
 									channel->setMode(LIMIT, PLUS);
-									if (!_paramsToSend.empty())
-										_paramsToSend += " ";
-									_paramsToSend += params.front();
+									if (!paramsToSend.empty())
+										paramsToSend += " ";
+									paramsToSend += params.front();
 								}
 							}
 							if (max > 0 || mp.first == MINUS)
 							{
-								// fill _modsToSend
-								if (_last != mp.first || _modsToSend.empty())
+								// fill modsToSend
+								if (last != mp.first || modsToSend.empty())
 								{
-									_last = mp.first;
-									_modsToSend += type_to_c(_last);
+									last = mp.first;
+									modsToSend += type_to_c(last);
 								}
-								_modsToSend += 'l';
+								modsToSend += 'l';
 							}
 							params.pop();
 						}
@@ -1120,6 +1277,8 @@ void	Mode::execute(User *user, s_msg &msg)
 					// Mode is o, called for first time and have params
 					else if (mp.second == O_MODE && !happened[O_MODE] && !params.empty())
 					{
+						User	*member = channel->findUserInChannel(params.front());
+
 						// user doesn't exist
 						if (_server->getUserWithNickname(params.front()) == NULL)
 						{
@@ -1127,26 +1286,26 @@ void	Mode::execute(User *user, s_msg &msg)
 							user->sendToClient(ERR_USERNOTINCHANNEL(user->getNickname(), params.front(), channel->getChannelName()));
 						}
 						// user exist but is not in channel
-						else if (channel->findUserInChannel(params.front()) == NULL)
+						else if (member == NULL)
 							user->sendToClient(ERR_USERNOTINCHANNEL(user->getNickname(), params.front(), channel->getChannelName()));
 
-						// user is in channel
+						// user is in channel (given with its nickname, not as typed)
 						else
 						{
 							if (mp.first == PLUS)
-								channel->setUserLevel(channel->findUserInChannel(params.front()), OPERATOR);
+								channel->setUserLevel(member, OPERATOR);
 							else
-								channel->setUserLevel(channel->findUserInChannel(params.front()), NORMAL);
+								channel->setUserLevel(member, NORMAL);
 							happened[O_MODE] = true;
-							if (_last != mp.first || _modsToSend.empty())
+							if (last != mp.first || modsToSend.empty())
 							{
-								_last = mp.first;
-								_modsToSend += type_to_c(_last);
+								last = mp.first;
+								modsToSend += type_to_c(last);
 							}
-							_modsToSend += 'o';
-							if (!_paramsToSend.empty())
-								_paramsToSend += " ";
-							_paramsToSend += params.front();
+							modsToSend += 'o';
+							if (!paramsToSend.empty())
+								paramsToSend += " ";
+							paramsToSend += member->getNickname();
 							params.pop();
 						}
 					}
@@ -1163,12 +1322,12 @@ void	Mode::execute(User *user, s_msg &msg)
 						happened[T_MODE] = true;
 
 						// fill the modes to send
-						if (_last != mp.first || _modsToSend.empty())
+						if (last != mp.first || modsToSend.empty())
 						{
-							_last = mp.first;
-							_modsToSend += type_to_c(_last);
+							last = mp.first;
+							modsToSend += type_to_c(last);
 						}
-						_modsToSend += 't';
+						modsToSend += 't';
 					}
 				/* #endregion */
 
@@ -1177,9 +1336,9 @@ void	Mode::execute(User *user, s_msg &msg)
 				}
 
 				// send the final message including all modifications done
-				if (!_modsToSend.empty())
+				if (!modsToSend.empty())
 				{
-					std::string fullMods = _modsToSend + " " + _paramsToSend;
+					std::string fullMods = modsToSend + " " + paramsToSend;
 					channel->sendToChannel(NULL, SEND_MODE_CHAN(user->getFullname(), channel->getChannelName(), fullMods));
 				}
 			}
@@ -1198,12 +1357,8 @@ Oper::~Oper() {  }
 
 void	Oper::execute(User *user, s_msg &msg)
 {
-		// user is not registered
-	if (user->getStatus() != REGISTERED)	
-		user->sendToClient(ERR_NOTREGISTERED(user->getNickname(), "OPER"));
-
 		// Not enough arguments given
-	else if (msg.args.empty() || msg.args.size() != 2)
+	if (msg.args.empty() || msg.args.size() != 2)
 		user->sendToClient(ERR_NEEDMOREPARAMS(user->getNickname(), "OPER"));
 
 		// Nickname or password is incorrect
@@ -1233,17 +1388,9 @@ Poweroff::~Poweroff() {  }
 
 void	Poweroff::execute(User *user, s_msg &msg)
 {
+	(void)user;
 	(void)msg;
-		// user is not registered
-	if (user->getStatus() != REGISTERED)
-		user->sendToClient(ERR_NOTREGISTERED(user->getNickname(), "POWEROFF"));
-
-		// user is not server Operator
-	else if (!user->isServerOp())
-		user->sendToClient(ERR_NOPRIVILEGES(user->getNickname()));
-
-		// user is allowed to shut down the server
-	else
-		_server->shutdown();
+	// registration and server operator checked by execute(): shut down the server
+	_server->powerOff();
 }
 /* #endregion */
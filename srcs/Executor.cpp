@@ -0,0 +1,264 @@
+#include "ft_irc.hpp"
+
+/* #region Constructor/Destructor */
+
+/**
+ * @brief Starts the threads executing commands
+ *
+ * @param nbOfThreads number of commands that can be waiting for the Server's lock
+ * @note Must be created once the signals are blocked, so that threads inherit the mask.
+ */
+Executor::Executor(Server *server, int nbOfThreads): _server(server), _stop(false)
+{
+	pthread_mutex_init(&_mutex, NULL);
+	pthread_cond_init(&_cond, NULL);
+	for (int i = 0; i < nbOfThreads; i++)
+	{
+		pthread_t	thread;
+
+		if (pthread_create(&thread, NULL, routine, this) != 0)
+		{
+			stop();
+			throw std::runtime_error("unable to create executor thread");
+		}
+		_threads.push_back(thread);
+	}
+}
+
+Executor::~Executor()
+{
+	stop();
+	pthread_cond_destroy(&_cond);
+	pthread_mutex_destroy(&_mutex);
+}
+/* #endregion */
+
+/* #region PUBLIC */
+
+/**
+ * @brief Number of commands the client's queue can still take
+ */
+int	Executor::getRoom(User *user)
+{
+	Lock	lock(_mutex);
+
+	return (COMMANDS_QUEUE_MAX - user->getCommandQueue().count);
+}
+
+/**
+ * @brief Adds commands at the end of the client's queue (from its Reactor)
+ *
+ * @param commands no more than getRoom(), cleared
+ * @return true if the queue is full: the Reactor must stop reading the client,
+ * it will be resumed once the queue has room (see run())
+ */
+bool	Executor::submit(User *user, std::vector<s_command> &commands)
+{
+	Lock			lock(_mutex);
+	s_commandQueue	&queue = user->getCommandQueue();
+
+	if (queue.commands.empty())
+		queue.commands.resize(COMMANDS_QUEUE_MAX);
+	for (size_t i = 0; i < commands.size(); i++)
+		queue.commands[(queue.first + queue.count++) % COMMANDS_QUEUE_MAX] = commands[i];
+	commands.clear();
+	schedule(user);
+	if (queue.count >= COMMANDS_QUEUE_MAX)
+		queue.stalled = true;
+	return (queue.stalled);
+}
+
+/**
+ * @brief Registration or nickname claim ended (Server's lock held): the commands waiting for it can be executed
+ */
+void	Executor::resume(User *user)
+{
+	Lock	lock(_mutex);
+
+	schedule(user);
+}
+
+/**
+ * @brief Executes the client's queue right away (Server's lock held), before its disconnection
+ *
+ * @return false if the client has been disconnected by one of its commands (QUIT)
+ * @note Called by the client's Reactor when the connection is closed, so that a
+ * QUIT sent just before keeps its message.
+ */
+bool	Executor::drain(User *user)
+{
+	s_command	command;
+
+	while (!user->isWaiting() && !user->isDisconnecting() && pop(user, false, command))
+	{
+		if (!_server->executeCommand(user, command.msg))
+			return (false);
+	}
+	return (true);
+}
+
+/**
+ * @brief The client is being deleted (Server's lock held), it must not be executed anymore
+ */
+void	Executor::forget(User *user)
+{
+	Lock						lock(_mutex);
+	std::deque<User *>::iterator	it = std::find(_ready.begin(), _ready.end(), user);
+
+	if (it != _ready.end())
+		_ready.erase(it);
+}
+
+/**
+ * @brief Stops the threads, commands left are not executed
+ */
+void	Executor::stop()
+{
+	{
+		Lock	lock(_mutex);
+
+		_stop = true;
+		pthread_cond_broadcast(&_cond);
+	}
+	for (std::vector<pthread_t>::iterator it = _threads.begin(); it != _threads.end(); it++)
+		pthread_join(*it, NULL);
+	_threads.clear();
+}
+
+/* #endregion */
+
+/* #region PRIVATE */
+
+void	*Executor::routine(void *executor)
+{
+	static_cast<Executor *>(executor)->work();
+	return (NULL);
+}
+
+/**
+ * @brief Thread loop: executes the ready clients until stop()
+ * @note The Server's lock is shared if the next command of the first ready client only
+ * reads (see isSharedCommand()): the commands of different clients then run at the same time.
+ * @note A client is only taken while holding the Server's lock, so it can't be
+ * deleted between the moment it is taken and its execution.
+ */
+void	Executor::work()
+{
+	while (true)
+	{
+		bool	isShared;
+		{
+			Lock	lock(_mutex);
+
+			while (_ready.empty() && !_stop)
+				pthread_cond_wait(&_cond, &_mutex);
+			if (_stop)
+				return ;
+			isShared = isNextShared(_ready.front());
+		}
+
+		ServerLock	serverLock(_server->getLock(), isShared);
+		User		*user = NULL;
+		{
+			Lock	lock(_mutex);
+
+			// another thread may have taken it, the next one may need the exclusive lock
+			if (!_ready.empty() && (!isShared || isNextShared(_ready.front())))
+			{
+				user = _ready.front();
+				_ready.pop_front();
+			}
+		}
+		if (user != NULL)
+			run(user, isShared);
+	}
+}
+
+/**
+ * @brief Executes up to LINES_BUDGET commands of the client (Server's lock held)
+ *
+ * @param isShared the lock is shared: stops before a command needing it exclusive,
+ * the client is scheduled again for it
+ * @note Commands after registration wait until the client is welcomed, the ones after a NICK
+ * until the Supervisor answered (see resume()).
+ * @note A client disconnected by its command (QUIT) is only deleted by its Reactor,
+ * at the end of the loop turn: the User stays valid here.
+ */
+void	Executor::run(User *user, bool isShared)
+{
+	int			budget = LINES_BUDGET;
+	s_command	command;
+
+	while (budget > 0 && !user->isWaiting() && !user->isDisconnecting() && pop(user, isShared, command))
+	{
+		budget--;
+		execute(_server, user, command.msg);
+	}
+
+	Lock			lock(_mutex);
+	s_commandQueue	&queue = user->getCommandQueue();
+
+	if (user->isDisconnecting())
+	{
+		for (; queue.count > 0; queue.count--, queue.first = (queue.first + 1) % COMMANDS_QUEUE_MAX)
+			queue.commands[queue.first].block = SharedBuffer();
+	}
+	queue.scheduled = false;
+	if (!user->isWaiting())
+		schedule(user);
+
+	// the client's Reactor can read again
+	if (queue.stalled && queue.count < COMMANDS_QUEUE_MAX)
+	{
+		queue.stalled = false;
+		user->getReactor()->resumeInput(user->getSocketFd());
+	}
+}
+
+/**
+ * @brief Takes the first command of the client's queue
+ *
+ * @param isShared only if the command can run under the shared lock
+ * @param command set to the command, its slot no longer references the line's block
+ * @return false if the queue is empty (or its first command needs the exclusive lock)
+ */
+bool	Executor::pop(User *user, bool isShared, s_command &command)
+{
+	Lock			lock(_mutex);
+	s_commandQueue	&queue = user->getCommandQueue();
+
+	if (queue.count == 0 || (isShared && !isNextShared(user)))
+		return (false);
+	command = queue.commands[queue.first];
+	queue.commands[queue.first].block = SharedBuffer();
+	queue.first = (queue.first + 1) % COMMANDS_QUEUE_MAX;
+	queue.count--;
+	return (true);
+}
+
+/**
+ * @brief Whether the first command of the client's queue can run under the shared lock (_mutex held)
+ * @note The queue of a ready client may have been emptied by drain().
+ */
+bool	Executor::isNextShared(User *user)
+{
+	s_commandQueue	&queue = user->getCommandQueue();
+
+	return (queue.count > 0 && queue.commands[queue.first].isShared);
+}
+
+/**
+ * @brief Adds the client to the ready list if it has commands and isn't there yet (_mutex held)
+ */
+void	Executor::schedule(User *user)
+{
+	s_commandQueue	&queue = user->getCommandQueue();
+
+	if (queue.scheduled || queue.count == 0)
+		return ;
+	queue.scheduled = true;
+	_ready.push_back(user);
+	pthread_cond_signal(&_cond);
+}
+
+/* #endregion */
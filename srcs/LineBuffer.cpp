@@ -0,0 +1,72 @@
+#include "ft_irc.hpp"
+
+/* #region Constructor/Destructor */
+
+LineBuffer::LineBuffer(): _start(0), _end(0) {  }
+LineBuffer::~LineBuffer() {  }
+/* #endregion */
+
+/* #region PUBLIC */
+
+/**
+ * @brief Returns where the next recv() must write, the unread tail is moved to the front
+ * if there is no room left for a full message
+ * @note Invalidates the slices returned by nextLine().
+ */
+char	*LineBuffer::prepare()
+{
+	if (_start == _end)
+		_start = _end = 0;
+	else if (_start > 0 && space() < MSG_MAX_LEN)
+	{
+		memmove(_data, _data + _start, _end - _start);
+		_end -= _start;
+		_start = 0;
+	}
+	return (_data + _end);
+}
+
+/**
+ * @brief Free space after the stored data
+ */
+size_t	LineBuffer::space() const { return (sizeof(_data) - _end); }
+
+/**
+ * @brief Validates the bytes written by recv() at prepare()
+ */
+void	LineBuffer::commit(size_t bytes) { _end += bytes; }
+
+/**
+ * @brief Frames the next complete line ("\r\n" or "\n"), without the line ending
+ *
+ * @param line set to the first char of the line, inside the buffer
+ * @param len set to the length of the line
+ * @return false if there is no complete line left
+ */
+bool	LineBuffer::nextLine(char const *&line, size_t &len)
+{
+	char const	*begin = _data + _start;
+	char const	*newline = Scanner::findByte(begin, _data + _end, '\n');
+
+	if (newline == _data + _end)
+		return (false);
+	line = begin;
+	len = newline - begin;
+	if (len > 0 && begin[len - 1] == '\r')
+		len--;
+	_start = newline + 1 - _data;
+	return (true);
+}
+
+/**
+ * @brief Checks if a complete line is waiting to be framed
+ */
+bool	LineBuffer::hasLine() const { return (Scanner::findByte(_data + _start, _data + _end, '\n') != _data + _end); }
+
+/**
+ * @brief Number of bytes received but not framed yet
+ */
+size_t	LineBuffer::size() const { return (_end - _start); }
+
+void	LineBuffer::clear() { _start = _end = 0; }
+/* #endregion */
@@ -0,0 +1,338 @@
+#include "ft_irc.hpp"
+
+s_logRecord		*Logger::_ring = NULL;
+unsigned long	Logger::_enqueuePos = 0;
+unsigned long	Logger::_dequeuePos = 0;
+unsigned long	Logger::_dropped = 0;
+e_logLevel		Logger::_level = LOG_DEV;
+bool			Logger::_running = false;
+pthread_t		Logger::_thread;
+pthread_mutex_t	Logger::_writeLock = PTHREAD_MUTEX_INITIALIZER;
+time_t			Logger::_stampTime = 0;
+char			Logger::_stamp[32] = "";
+
+/**
+ * @brief Copies a C string in a record field, cut to fit
+ */
+static void	copyField(char *field, char const *str, size_t size)
+{
+	size_t	len = 0;
+
+	if (str != NULL)
+	{
+		while (len < size - 1 && str[len] != '\0')
+			len++;
+		std::memcpy(field, str, len);
+	}
+	field[len] = '\0';
+}
+
+static void	fillRecord(s_logRecord &record, e_logLevel level, char const *text, int fd, char const *nick, char const *channel)
+{
+	record.level = level;
+	record.fd = fd;
+	copyField(record.nick, nick, sizeof(record.nick));
+	copyField(record.channel, channel, sizeof(record.channel));
+	copyField(record.text, text, sizeof(record.text));
+}
+
+/* #region PUBLIC */
+
+/**
+ * @brief Reads the lowest level to write (IRC_LOG_LEVEL: dev, info, error or off,
+ * dev by default) and starts the logging thread
+ * @note Messages logged before are written directly.
+ */
+void	Logger::start()
+{
+	static char const	*names[] = {"dev", "info", "error", "off"};
+	char const			*level = getenv("IRC_LOG_LEVEL");
+	static bool			isForkHandled = false;
+
+	if (level != NULL)
+	{
+		int	i = LOG_DEV;
+
+		while (i <= LOG_OFF && std::strcmp(level, names[i]) != 0)
+			i++;
+		if (i > LOG_OFF)
+			throw std::invalid_argument("invalid log level: " + std::string(level));
+		_level = static_cast<e_logLevel>(i);
+	}
+
+	_ring = new s_logRecord[LOG_RING_SIZE];
+	for (unsigned long pos = 0; pos < LOG_RING_SIZE; pos++)
+		_ring[pos].seq = pos;
+	_enqueuePos = 0;
+	_dequeuePos = 0;
+
+	// workers processes have their own logging thread (see afterForkChild())
+	if (!isForkHandled && pthread_atfork(beforeFork, afterForkParent, afterForkChild) == 0)
+		isForkHandled = true;
+	startThread();
+}
+
+/**
+ * @brief Writes the waiting messages and stops the logging thread,
+ * messages logged after are written directly
+ */
+void	Logger::stop()
+{
+	if (_ring == NULL)
+		return ;
+	if (__atomic_load_n(&_running, __ATOMIC_ACQUIRE))
+	{
+		__atomic_store_n(&_running, false, __ATOMIC_RELEASE);
+		pthread_join(_thread, NULL);
+	}
+	drain();
+	delete[] _ring;
+	_ring = NULL;
+}
+
+/**
+ * @brief Whether the messages of this level are written
+ */
+bool	Logger::isEnabled(e_logLevel level)
+{
+	if (level == LOG_DEV && !LOG_DEV_MESSAGES)
+		return (false);
+	return (level >= _level && level != LOG_OFF);
+}
+
+void	Logger::log(e_logLevel level, std::string const &text)
+{
+	log(level, text.c_str(), ERROR, NULL, NULL);
+}
+
+/**
+ * @brief Queues a message for the logging thread, never blocks
+ *
+ * @param fd client's socket, ERROR if none
+ * @param nick client's nickname, NULL if none
+ * @param channel channel concerned, NULL if none
+ * @note Bounded MPMC ring (D. Vyukov): a position is claimed with a CAS, then the
+ * record is marked ready by its sequence number. If the ring is full, the message
+ * is dropped and counted.
+ */
+void	Logger::log(e_logLevel level, char const *text, int fd, char const *nick, char const *channel)
+{
+	if (!isEnabled(level))
+		return ;
+
+	// not started (or stopped): written directly
+	if (_ring == NULL)
+	{
+		s_logRecord	record;
+		std::string	out;
+		std::string	err;
+
+		fillRecord(record, level, text, fd, nick, channel);
+		format(record, time(NULL), out, err);
+		writeAll(STDOUT_FILENO, out);
+		writeAll(STDERR_FILENO, err);
+		return ;
+	}
+
+	s_logRecord		*record;
+	unsigned long	pos = __atomic_load_n(&_enqueuePos, __ATOMIC_RELAXED);
+
+	while (true)
+	{
+		record = &_ring[pos & (LOG_RING_SIZE - 1)];
+
+		long	diff = static_cast<long>(__atomic_load_n(&record->seq, __ATOMIC_ACQUIRE) - pos);
+
+		if (diff == 0)
+		{
+			if (__atomic_compare_exchange_n(&_enqueuePos, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+				break ;
+		}
+		else if (diff < 0)
+		{
+			__atomic_add_fetch(&_dropped, 1, __ATOMIC_RELAXED);
+			return ;
+		}
+		else
+			pos = __atomic_load_n(&_enqueuePos, __ATOMIC_RELAXED);
+	}
+	fillRecord(*record, level, text, fd, nick, channel);
+	__atomic_store_n(&record->seq, pos + 1, __ATOMIC_RELEASE);
+}
+
+/* #endregion */
+
+/* #region PRIVATE */
+
+/**
+ * @brief Logging thread: writes the ready records, sleeps when there is none
+ */
+void	*Logger::routine(void *unused)
+{
+	(void)unused;
+	while (true)
+	{
+		bool	isRunning = __atomic_load_n(&_running, __ATOMIC_ACQUIRE);
+		size_t	written;
+
+		pthread_mutex_lock(&_writeLock);
+		written = drain();
+		pthread_mutex_unlock(&_writeLock);
+		if (!isRunning)
+			break ;
+		if (written == 0)
+			usleep(LOG_DRAIN_INTERVAL * 1000);
+	}
+	return (NULL);
+}
+
+/**
+ * @brief Creates the logging thread, signals stay for the other threads (signalfd)
+ */
+void	Logger::startThread()
+{
+	sigset_t	all;
+	sigset_t	previous;
+	int			ret;
+
+	sigfillset(&all);
+	pthread_sigmask(SIG_BLOCK, &all, &previous);
+	_running = true;
+	ret = pthread_create(&_thread, NULL, routine, NULL);
+	pthread_sigmask(SIG_SETMASK, &previous, NULL);
+	if (ret != 0)
+	{
+		_running = false;
+		delete[] _ring;
+		_ring = NULL;
+		throw std::runtime_error("unable to create logging thread: " + std::string(strerror(ret)));
+	}
+}
+
+/**
+ * @brief Writes the ready records (one write() for each output)
+ *
+ * @return number of records written
+ * @note Only called by one thread at a time (_writeLock, or the thread is stopped).
+ */
+size_t	Logger::drain()
+{
+	std::string		out;
+	std::string		err;
+	size_t			written = 0;
+	unsigned long	dropped = __atomic_exchange_n(&_dropped, 0, __ATOMIC_RELAXED);
+	time_t			now = time(NULL);		// stamp of the whole batch
+
+	while (true)
+	{
+		s_logRecord	&record = _ring[_dequeuePos & (LOG_RING_SIZE - 1)];
+
+		if (__atomic_load_n(&record.seq, __ATOMIC_ACQUIRE) != _dequeuePos + 1)
+			break ;
+		format(record, now, out, err);
+		__atomic_store_n(&record.seq, _dequeuePos + LOG_RING_SIZE, __ATOMIC_RELEASE);
+		_dequeuePos++;
+		written++;
+	}
+	if (dropped > 0)
+	{
+		s_logRecord	record;
+
+		fillRecord(record, LOG_INFO, std::string(MSG_LOG_DROPPED(dropped)).c_str(), ERROR, NULL, NULL);
+		format(record, now, out, err);
+	}
+	writeAll(STDOUT_FILENO, out);
+	writeAll(STDERR_FILENO, err);
+	return (written);
+}
+
+/**
+ * @brief Formats a record: "dev" on stdout, "info" on stdout with the time, "error" on stderr.
+ * The fields follow the message (fd=5 nick=bob channel=#chan).
+ *
+ * @param now time the record is stamped with (read once per batch by drain())
+ */
+void	Logger::format(s_logRecord const &record, time_t now, std::string &out, std::string &err)
+{
+	std::string	&dest = record.level == LOG_ERROR ? err : out;
+
+	if (record.level == LOG_DEV)
+		dest.append(CYAN "-> ");
+	else if (record.level == LOG_ERROR)
+		dest.append(RED "Error: ");
+	else
+	{
+		if (now != _stampTime)
+		{
+			tm	timeinfo;
+
+			localtime_r(&now, &timeinfo);
+			strftime(_stamp, sizeof(_stamp), "%d/%m/%Y %H:%M:%S :", &timeinfo);
+			_stampTime = now;
+		}
+		dest.append(GREY).append(_stamp).append(NO_COLOR " ");
+	}
+	dest.append(record.text);
+	if (record.fd != ERROR)
+		dest.append(" fd=").append(to_string(record.fd));
+	if (record.nick[0] != '\0')
+		dest.append(" nick=").append(record.nick);
+	if (record.channel[0] != '\0')
+		dest.append(" channel=").append(record.channel);
+	if (record.level != LOG_INFO)
+		dest.append(NO_COLOR);
+	dest.append("\n");
+}
+
+void	Logger::writeAll(int fd, std::string const &data)
+{
+	size_t	done = 0;
+
+	while (done < data.size())
+	{
+		ssize_t	ret = write(fd, data.data() + done, data.size() - done);
+
+		if (ret == ERROR && errno == EINTR)
+			continue ;
+		if (ret <= 0)
+			return ;
+		done += ret;
+	}
+}
+
+/**
+ * @brief Before fork(): the waiting records are written, the child won't write them again
+ */
+void	Logger::beforeFork()
+{
+	if (_ring == NULL)
+		return ;
+	pthread_mutex_lock(&_writeLock);
+	drain();
+}
+
+void	Logger::afterForkParent()
+{
+	if (_ring != NULL)
+		pthread_mutex_unlock(&_writeLock);
+}
+
+/**
+ * @brief In the child, only the forking thread exists: a new logging thread is started
+ */
+void	Logger::afterForkChild()
+{
+	if (_ring == NULL)
+		return ;
+	pthread_mutex_unlock(&_writeLock);
+	try
+	{
+		startThread();
+	}
+	catch (std::exception const &)
+	{
+		// messages are written directly
+	}
+}
+
+/* #endregion */
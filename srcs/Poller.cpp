@@ -0,0 +1,1019 @@
+#include "Poller.hpp"
+
+/* #region POLLER */
+
+Poller::Poller() {  }
+Poller::~Poller() {  }
+
+std::vector<pollfd> const	&Poller::getReady() const { return (_ready); }
+
+/**
+ * @brief Watches a client's socket for POLLIN, the Reactor changes it with modify()
+ */
+void	Poller::addClient(int fd) { add(fd, POLLIN); }
+
+/**
+ * @brief Watches the server socket, its connections are taken with accept()
+ */
+void	Poller::addListener(int fd) { add(fd, POLLIN); }
+
+/**
+ * @brief Takes a connection waiting on the server socket
+ *
+ * @param addr set to the client's address
+ * @return the client's socket (non blocking, close on exec), or ERROR with errno set
+ */
+int	Poller::accept(int fd, sockaddr_in &addr)
+{
+	socklen_t	len = sizeof(addr);
+
+	return (accept4(fd, reinterpret_cast<sockaddr *>(&addr), &len, SOCK_NONBLOCK | SOCK_CLOEXEC));
+}
+
+/**
+ * @brief Reads what a client sent
+ *
+ * @return as recv(): bytes read, 0 at the end of the stream, or ERROR with errno set
+ */
+ssize_t	Poller::receive(int fd, char *buffer, size_t len)
+{
+	return (recv(fd, buffer, len, MSG_DONTWAIT));
+}
+
+/**
+ * @brief Bytes received from a client that the engine keeps until they are read
+ */
+size_t	Poller::getReceived(int fd) const
+{
+	(void)fd;
+	return (0);
+}
+
+/**
+ * @brief Sends the messages of several clients (the count first ones of batch),
+ * the result of each one is set
+ */
+void	Poller::send(std::vector<s_send> &batch, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+		sendNow(batch[i]);
+}
+
+/**
+ * @brief sendmsg() of a client's messages, without blocking nor SIGPIPE
+ */
+void	Poller::sendNow(s_send &send)
+{
+	do
+		send.result = sendmsg(send.fd, &send.msg, MSG_DONTWAIT | MSG_NOSIGNAL);
+	while (send.result == ERROR && errno == EINTR);
+	if (send.result == ERROR)
+		send.result = -errno;
+}
+
+/**
+ * @brief Creates the engine asked in configuration
+ *
+ * @param engine "io_uring", "epoll" or "poll"
+ * @note If the kernel doesn't support the engine, falls back on the next one (io_uring -> epoll -> poll).
+ */
+Poller	*Poller::create(std::string const &engine)
+{
+	if (engine == "poll")
+		return (new PollPoller());
+	if (engine == "io_uring")
+	{
+		try
+		{
+			return (new UringPoller());
+		}
+		catch (const std::exception &e)
+		{
+			MSG_ERR(std::string(e.what()) + ", falling back on epoll");
+		}
+	}
+	else if (engine != "epoll")
+		MSG_ERR("unknown engine '" + engine + "', using epoll");
+	try
+	{
+		return (new EpollPoller());
+	}
+	catch (const std::exception &e)
+	{
+		MSG_ERR(std::string(e.what()) + ", falling back on poll");
+	}
+	return (new PollPoller());
+}
+/* #endregion */
+
+/* #region POLL */
+
+PollPoller::PollPoller() {  }
+PollPoller::~PollPoller() {  }
+
+void	PollPoller::add(int fd, short events)
+{
+	pollfd	newPoll;
+
+	if (fd >= static_cast<int>(_slots.size()))
+		_slots.resize(fd + 1, -1);
+	newPoll.fd = fd;
+	newPoll.events = events;
+	newPoll.revents = 0;
+	_slots[fd] = _fds.size();
+	_fds.push_back(newPoll);
+}
+
+void	PollPoller::modify(int fd, short events)
+{
+	if (fd < static_cast<int>(_slots.size()) && _slots[fd] != -1)
+		_fds[_slots[fd]].events = events;
+}
+
+/**
+ * @brief Stops watching a FD, the last pollfd takes its slot
+ */
+void	PollPoller::remove(int fd)
+{
+	if (fd >= static_cast<int>(_slots.size()) || _slots[fd] == -1)
+		return ;
+
+	int	slot = _slots[fd];
+
+	_fds[slot] = _fds.back();
+	_slots[_fds[slot].fd] = slot;
+	_fds.pop_back();
+	_slots[fd] = -1;
+}
+
+/**
+ * @brief Waits for events and copies the ready pollfds
+ *
+ * @return number of ready FDs
+ */
+int	PollPoller::wait(int timeout)
+{
+	_ready.clear();
+	if (poll(_fds.data(), _fds.size(), timeout) == ERROR)
+	{
+		if (errno == EINTR)
+			return (0);
+		throw std::runtime_error("poll error: " + std::string(strerror(errno)));
+	}
+	for (size_t i = 0; i < _fds.size(); i++)
+	{
+		if (_fds[i].revents)
+			_ready.push_back(_fds[i]);
+	}
+	return (_ready.size());
+}
+
+std::string	PollPoller::getName() const { return ("poll"); }
+/* #endregion */
+
+/* #region EPOLL */
+
+static uint32_t	toEpoll(short events)
+{
+	uint32_t	res = 0;
+
+	if (events & POLLIN)
+		res |= EPOLLIN;
+	if (events & POLLOUT)
+		res |= EPOLLOUT;
+	return (res);
+}
+
+static short	fromEpoll(uint32_t events)
+{
+	short	res = 0;
+
+	if (events & EPOLLIN)
+		res |= POLLIN;
+	if (events & EPOLLOUT)
+		res |= POLLOUT;
+	if (events & EPOLLERR)
+		res |= POLLERR;
+	if (events & EPOLLHUP)
+		res |= POLLHUP;
+	return (res);
+}
+
+EpollPoller::EpollPoller(): _nbOfFds(0), _events(64)
+{
+	if ((_epollFd = epoll_create1(EPOLL_CLOEXEC)) == ERROR)
+		throw std::runtime_error("unable to create epoll instance: " + std::string(strerror(errno)));
+}
+
+EpollPoller::~EpollPoller() { close(_epollFd); }
+
+void	EpollPoller::add(int fd, short events)
+{
+	epoll_event	ev;
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events = toEpoll(events);
+	ev.data.fd = fd;
+	if (epoll_ctl(_epollFd, EPOLL_CTL_ADD, fd, &ev) == ERROR)
+		throw std::runtime_error("epoll_ctl error: " + std::string(strerror(errno)));
+	_nbOfFds++;
+}
+
+void	EpollPoller::modify(int fd, short events)
+{
+	epoll_event	ev;
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events = toEpoll(events);
+	ev.data.fd = fd;
+	if (epoll_ctl(_epollFd, EPOLL_CTL_MOD, fd, &ev) == ERROR)
+		MSG_ERR(strerror(errno));
+}
+
+void	EpollPoller::remove(int fd)
+{
+	epoll_event	ev;
+
+	memset(&ev, 0, sizeof(ev));
+	if (epoll_ctl(_epollFd, EPOLL_CTL_DEL, fd, &ev) != ERROR)
+		_nbOfFds--;
+}
+
+/**
+ * @brief Waits for events, only the ready FDs are returned by the kernel
+ *
+ * @return number of ready FDs
+ * @note The output array grows with the number of watched FDs, so a single
+ * call can report every ready connection.
+ */
+int	EpollPoller::wait(int timeout)
+{
+	if (_nbOfFds > static_cast<int>(_events.size()))
+		_events.resize(_nbOfFds);
+
+	_ready.clear();
+	int	n = epoll_wait(_epollFd, _events.data(), _events.size(), timeout);
+	if (n == ERROR)
+	{
+		if (errno == EINTR)
+			return (0);
+		throw std::runtime_error("epoll_wait error: " + std::string(strerror(errno)));
+	}
+	for (int i = 0; i < n; i++)
+	{
+		pollfd	ready;
+
+		ready.fd = _events[i].data.fd;
+		ready.events = 0;
+		ready.revents = fromEpoll(_events[i].events);
+		_ready.push_back(ready);
+	}
+	return (n);
+}
+
+std::string	EpollPoller::getName() const { return ("epoll"); }
+/* #endregion */
+
+
+/* #region IO_URING */
+
+# define URING_ENTRIES		256
+# define URING_CQ_ENTRIES	4096
+# define URING_BUFFERS		256					// provided buffers of the recv requests (power of 2)
+# define URING_BUFFER_SIZE	4096
+# define URING_BUFFER_GROUP	0
+# define URING_RECEIVED_MAX	(2 * RECV_BUDGET)	// bytes waiting for the Reactor before a client's recv is cancelled
+# define URING_ACCEPTED_MAX	ACCEPT_BUDGET		// sockets waiting for the Server before the accept is cancelled
+# define URING_SEQ_MASK		0x0fffffffU
+
+enum	e_uringKind { URING_OP_RECV = 1, URING_OP_ACCEPT, URING_OP_POLL, URING_OP_SEND, URING_OP_CANCEL };
+
+/**
+ * @brief user_data of a request: kind in the 4 high bits, sequence number of the FD, FD in the low bits
+ * @note For a send, the FD bits hold its index in the batch.
+ */
+static uint64_t	toUserData(e_uringKind kind, uint32_t seq, int fd)
+{
+	return ((static_cast<uint64_t>(kind) << 60) | (static_cast<uint64_t>(seq & URING_SEQ_MASK) << 32)
+		| static_cast<uint32_t>(fd));
+}
+
+/**
+ * @brief Creates the ring, maps the submission/completion queues and registers the provided buffers
+ * @note Throws if io_uring is not available (old kernel, seccomp...) or lacks the needed features
+ * (multishot recv: Linux 6.0).
+ */
+UringPoller::UringPoller():
+	_ringFd(ERROR), _sqRing(MAP_FAILED), _sqRingSize(0), _sqLocalTail(0), _sqes(NULL), _sqesSize(0),
+	_cqRing(MAP_FAILED), _cqRingSize(0), _bufRing(NULL), _buffers(NULL), _bufRingSize(0),
+	_batch(NULL), _sendsLeft(0)
+{
+	io_uring_params	params;
+
+	memset(&params, 0, sizeof(params));
+	params.flags = IORING_SETUP_CQSIZE;
+	params.cq_entries = URING_CQ_ENTRIES;
+	if ((_ringFd = syscall(__NR_io_uring_setup, URING_ENTRIES, &params)) == ERROR)
+		throw std::runtime_error("unable to create io_uring instance: " + std::string(strerror(errno)));
+	if (!(params.features & IORING_FEAT_EXT_ARG) || !(params.features & IORING_FEAT_NODROP))
+	{
+		release();
+		throw std::runtime_error("io_uring instance lacks needed features");
+	}
+
+	// 1) map the rings (a single mapping for both on recent kernels)
+	_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+	if (params.features & IORING_FEAT_SINGLE_MMAP)
+		_sqRingSize = std::max(_sqRingSize, _cqRingSize);
+	_sqRing = mmap(NULL, _sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ringFd, IORING_OFF_SQ_RING);
+	if (_sqRing != MAP_FAILED && !(params.features & IORING_FEAT_SINGLE_MMAP))
+		_cqRing = mmap(NULL, _cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ringFd, IORING_OFF_CQ_RING);
+	_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+	void	*sqes = mmap(NULL, _sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ringFd, IORING_OFF_SQES);
+	if (sqes != MAP_FAILED)
+		_sqes = static_cast<io_uring_sqe *>(sqes);
+	if (_sqRing == MAP_FAILED || _sqes == NULL || (!(params.features & IORING_FEAT_SINGLE_MMAP) && _cqRing == MAP_FAILED))
+	{
+		release();
+		throw std::runtime_error("unable to map io_uring queues: " + std::string(strerror(errno)));
+	}
+
+	// 2) queues pointers
+	char	*sq = static_cast<char *>(_sqRing);
+	char	*cq = (params.features & IORING_FEAT_SINGLE_MMAP) ? sq : static_cast<char *>(_cqRing);
+
+	_sqHead = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+	_sqTail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+	_sqMask = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+	_sqArray = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+	_sqEntries = params.sq_entries;
+	_sqLocalTail = *_sqTail;
+	_cqHead = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+	_cqTail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+	_cqMask = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+	_cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+
+	// 3) provided buffers, then check that multishot recv really works
+	try
+	{
+		setBufferRing();
+		probe();
+	}
+	catch (...)
+	{
+		release();
+		throw ;
+	}
+}
+
+UringPoller::~UringPoller()
+{
+	for (size_t fd = 0; fd < _fds.size(); fd++)
+		for (size_t i = 0; i < _fds[fd].accepted.size(); i++)
+			if (_fds[fd].accepted[i] >= 0)
+				close(_fds[fd].accepted[i]);
+	release();
+}
+
+void	UringPoller::release()
+{
+	if (_sqes != NULL)
+		munmap(_sqes, _sqesSize);
+	if (_cqRing != MAP_FAILED)
+		munmap(_cqRing, _cqRingSize);
+	if (_sqRing != MAP_FAILED)
+		munmap(_sqRing, _sqRingSize);
+	if (_ringFd != ERROR)
+		close(_ringFd);
+	if (_bufRing != NULL)
+		munmap(_bufRing, _bufRingSize + URING_BUFFERS * URING_BUFFER_SIZE);
+	_sqes = NULL;
+	_cqRing = MAP_FAILED;
+	_sqRing = MAP_FAILED;
+	_ringFd = ERROR;
+	_bufRing = NULL;
+}
+
+/**
+ * @brief Maps the provided buffer ring (and its buffers right after it) and registers it
+ */
+void	UringPoller::setBufferRing()
+{
+	_bufRingSize = URING_BUFFERS * sizeof(io_uring_buf);
+
+	void	*ring = mmap(NULL, _bufRingSize + URING_BUFFERS * URING_BUFFER_SIZE, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+	if (ring == MAP_FAILED)
+		throw std::runtime_error("unable to map io_uring buffers: " + std::string(strerror(errno)));
+	_bufRing = static_cast<io_uring_buf *>(ring);
+	_buffers = static_cast<char *>(ring) + _bufRingSize;
+
+	io_uring_buf_reg	reg;
+
+	memset(&reg, 0, sizeof(reg));
+	reg.ring_addr = reinterpret_cast<uint64_t>(ring);
+	reg.ring_entries = URING_BUFFERS;
+	reg.bgid = URING_BUFFER_GROUP;
+	if (syscall(__NR_io_uring_register, _ringFd, IORING_REGISTER_PBUF_RING, &reg, 1) == ERROR)
+		throw std::runtime_error("io_uring instance lacks provided buffer rings");
+	for (unsigned short bufferId = 0; bufferId < URING_BUFFERS; bufferId++)
+		recycle(bufferId);
+}
+
+/**
+ * @brief Gives a buffer back to the kernel
+ * @note io_uring_buf_ring isn't used: in C++ its empty struct moves bufs after the tail.
+ */
+void	UringPoller::recycle(unsigned short bufferId)
+{
+	unsigned short	tail = _bufRing[0].resv;
+	io_uring_buf	*buffer = &_bufRing[tail & (URING_BUFFERS - 1)];
+
+	buffer->addr = reinterpret_cast<uint64_t>(_buffers + bufferId * URING_BUFFER_SIZE);
+	buffer->len = URING_BUFFER_SIZE;
+	buffer->bid = bufferId;
+	__atomic_store_n(&_bufRing[0].resv, static_cast<unsigned short>(tail + 1), __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief A byte written to a socket pair must complete the recv and keep it armed
+ * @note Kernels without multishot recv complete it with -EINVAL.
+ */
+void	UringPoller::probe()
+{
+	int	pair[2];
+
+	if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, pair) == ERROR)
+		throw std::runtime_error("unable to probe io_uring: " + std::string(strerror(errno)));
+	addClient(pair[0]);
+
+	bool	isSupported = (write(pair[1], "", 1) == 1 && wait(1000) == 1
+		&& _fds[pair[0]].readArmed && _fds[pair[0]].received.size() == 1);
+
+	remove(pair[0]);
+	close(pair[0]);
+	close(pair[1]);
+	_ready.clear();
+	if (!isSupported)
+		throw std::runtime_error("io_uring instance lacks multishot recv");
+}
+
+/**
+ * @brief Reserves the next SQE, the queue is submitted first if it is full
+ */
+io_uring_sqe	*UringPoller::getSqe()
+{
+	while (_sqLocalTail - __atomic_load_n(_sqHead, __ATOMIC_ACQUIRE) >= _sqEntries)
+	{
+		submit(0, -1);
+		reap();			// the kernel doesn't take SQEs while completions overflow
+	}
+
+	unsigned		index = _sqLocalTail & *_sqMask;
+	io_uring_sqe	*sqe = &_sqes[index];
+
+	memset(sqe, 0, sizeof(*sqe));
+	_sqArray[index] = index;
+	_sqLocalTail++;
+	return (sqe);
+}
+
+/**
+ * @brief Publishes the filled SQEs and enters the kernel
+ *
+ * @param minComplete number of completions to wait for (0 to only submit)
+ * @param timeout max time to wait in ms, -1 for no limit
+ */
+void	UringPoller::submit(unsigned minComplete, int timeout)
+{
+	io_uring_getevents_arg	arg;
+	__kernel_timespec		ts;
+	unsigned				flags = 0;
+
+	__atomic_store_n(_sqTail, _sqLocalTail, __ATOMIC_RELEASE);
+	memset(&arg, 0, sizeof(arg));
+	if (minComplete > 0)
+	{
+		flags = IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+		if (timeout >= 0)
+		{
+			ts.tv_sec = timeout / 1000;
+			ts.tv_nsec = (timeout % 1000) * 1000000L;
+			arg.ts = reinterpret_cast<uint64_t>(&ts);
+		}
+	}
+	unsigned	toSubmit = _sqLocalTail - __atomic_load_n(_sqHead, __ATOMIC_ACQUIRE);
+	if (syscall(__NR_io_uring_enter, _ringFd, toSubmit, minComplete, flags, &arg, sizeof(arg)) == ERROR
+		&& errno != EINTR && errno != ETIME && errno != EBUSY)
+		throw std::runtime_error("io_uring_enter error: " + std::string(strerror(errno)));
+}
+
+/**
+ * @brief Handles every completion of the queue
+ */
+void	UringPoller::reap()
+{
+	unsigned	head = *_cqHead;
+	unsigned	tail = __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE);
+
+	while (head != tail)
+	{
+		io_uring_cqe	cqe = _cqes[head & *_cqMask];
+
+		__atomic_store_n(_cqHead, ++head, __ATOMIC_RELEASE);
+		complete(cqe);
+	}
+}
+
+void	UringPoller::complete(io_uring_cqe const &cqe)
+{
+	e_uringKind	kind = static_cast<e_uringKind>(cqe.user_data >> 60);
+	uint32_t	seq = static_cast<uint32_t>(cqe.user_data >> 32) & URING_SEQ_MASK;
+	int			fd = static_cast<int>(cqe.user_data & 0xffffffff);
+
+	if (kind == URING_OP_SEND && _batch != NULL)
+	{
+		(*_batch)[fd].result = cqe.res;
+		_sendsLeft--;
+	}
+	else if (kind == URING_OP_RECV)
+		completeRecv(fd, seq, cqe);
+	else if (kind == URING_OP_ACCEPT)
+		completeAccept(fd, seq, cqe);
+	else if (kind == URING_OP_POLL)
+		completePoll(fd, seq, cqe);
+}
+
+/**
+ * @brief State of a FD if the request numbered seq was submitted since it is watched
+ * @return NULL for the completions of a FD that was removed (and maybe watched again since)
+ */
+s_uringFd	*UringPoller::getState(int fd, uint32_t seq)
+{
+	if (fd < 0 || fd >= static_cast<int>(_fds.size()) || _fds[fd].role == URING_UNWATCHED)
+		return (NULL);
+
+	s_uringFd	&state = _fds[fd];
+
+	if (((seq - state.firstSeq) & URING_SEQ_MASK) >= ((_seqs[fd] - state.firstSeq) & URING_SEQ_MASK))
+		return (NULL);
+	return (&state);
+}
+
+/**
+ * @brief A client's data (or its end, or an error) is kept until the Reactor reads it
+ * @note The buffer goes back to the ring at once. When the recv stops (cancelled, no buffer left),
+ * the FD is updated to re-arm it if it is still wanted.
+ */
+void	UringPoller::completeRecv(int fd, uint32_t seq, io_uring_cqe const &cqe)
+{
+	s_uringFd	*state = getState(fd, seq);
+
+	if (state != NULL)
+	{
+		short	readable = state->events & POLLIN;		// a paused client is not reported
+
+		if (cqe.res > 0 && (cqe.flags & IORING_CQE_F_BUFFER))
+		{
+			if (state->offset > 0 && state->offset >= state->received.size() / 2)
+			{
+				state->received.erase(0, state->offset);
+				state->offset = 0;
+			}
+			state->received.append(_buffers + (cqe.flags >> IORING_CQE_BUFFER_SHIFT) * URING_BUFFER_SIZE, cqe.res);
+			report(fd, readable);
+		}
+		else if (cqe.res == 0)
+		{
+			state->eof = true;
+			report(fd, readable);
+		}
+		else if (cqe.res != -ENOBUFS && cqe.res != -ECANCELED)
+		{
+			state->error = -cqe.res;
+			report(fd, readable | POLLERR);
+		}
+		if (!(cqe.flags & IORING_CQE_F_MORE) && seq == state->readSeq)
+		{
+			state->readArmed = false;
+			state->readCancelled = false;
+			markDirty(fd);
+		}
+		else if (state->received.size() - state->offset >= URING_RECEIVED_MAX)
+			markDirty(fd);
+		if (state->received.size() > state->offset || state->eof || state->error)
+			_waiting.insert(fd);
+	}
+	if (cqe.flags & IORING_CQE_F_BUFFER)
+		recycle(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+}
+
+/**
+ * @brief An accepted socket (or the accept's error) is kept until the Server takes it
+ * @note Sockets accepted for a listener that was removed are closed.
+ */
+void	UringPoller::completeAccept(int fd, uint32_t seq, io_uring_cqe const &cqe)
+{
+	s_uringFd	*state = getState(fd, seq);
+
+	if (state == NULL)
+	{
+		if (cqe.res >= 0)
+			close(cqe.res);
+		return ;
+	}
+	if (cqe.res != -ECANCELED)
+	{
+		state->accepted.push_back(cqe.res);
+		_waiting.insert(fd);
+		report(fd, POLLIN);
+	}
+	if (!(cqe.flags & IORING_CQE_F_MORE) && seq == state->readSeq)
+	{
+		state->readArmed = false;
+		state->readCancelled = false;
+		markDirty(fd);
+	}
+	else if (state->accepted.size() >= URING_ACCEPTED_MAX)
+		markDirty(fd);
+}
+
+/**
+ * @brief Reports the events of a one-shot poll, it is re-armed by the next wait() if still asked
+ * @note A poll reporting nothing asked (a paused client's peer shut down its side) isn't re-armed
+ * until the events change, it would complete again at once.
+ */
+void	UringPoller::completePoll(int fd, uint32_t seq, io_uring_cqe const &cqe)
+{
+	s_uringFd	*state = getState(fd, seq);
+
+	if (state == NULL || !state->pollArmed || seq != state->pollSeq || cqe.res == -ECANCELED)
+		return ;
+	state->pollArmed = false;
+
+	short	revents = (cqe.res < 0 ? POLLERR : static_cast<short>(cqe.res & (state->pollEvents | POLLERR | POLLHUP)));
+
+	if (revents != 0)
+		report(fd, revents);
+	else
+		state->pollIdle = true;
+	markDirty(fd);
+}
+
+void	UringPoller::report(int fd, short revents)
+{
+	if (revents == 0)
+		return ;
+	if (_revents[fd] == 0)
+		_completed.push_back(fd);
+	_revents[fd] |= revents;
+}
+
+/**
+ * @brief Starts watching a FD, its requests are armed by the next wait()
+ */
+void	UringPoller::watch(int fd, e_uringRole role, short events)
+{
+	if (fd >= static_cast<int>(_fds.size()))
+	{
+		_fds.resize(fd + 1);
+		_seqs.resize(fd + 1, 0);
+		_revents.resize(fd + 1, 0);
+	}
+
+	s_uringFd	&state = _fds[fd];
+	bool		dirty = state.dirty;
+
+	state = s_uringFd();
+	state.role = role;
+	state.events = events;
+	state.firstSeq = _seqs[fd];
+	state.dirty = dirty;
+	markDirty(fd);
+}
+
+void	UringPoller::markDirty(int fd)
+{
+	if (_fds[fd].dirty)
+		return ;
+	_fds[fd].dirty = true;
+	_dirty.push_back(fd);
+}
+
+/**
+ * @brief Arms or cancels the requests of a FD to match what is asked
+ *
+ * - client: multishot recv while POLLIN is asked, the stream isn't over and not too much is
+ *   waiting; poll for POLLOUT, or for POLLERR/POLLHUP alone while paused,
+ * - listener: multishot accept while not too many sockets are waiting,
+ * - other FDs: poll for the events asked.
+ */
+void	UringPoller::update(int fd)
+{
+	s_uringFd	&state = _fds[fd];
+	bool		wantRead = false;
+	bool		wantPoll = false;
+	short		pollEvents = state.events;
+
+	state.dirty = false;
+	if (state.role == URING_UNWATCHED)
+		return ;
+	if (state.role == URING_READY)
+		wantPoll = (state.events != 0);
+	else if (state.role == URING_LISTENER)
+		wantRead = (state.accepted.size() < URING_ACCEPTED_MAX);
+	else
+	{
+		wantRead = ((state.events & POLLIN) && !state.eof && !state.error
+			&& state.received.size() - state.offset < URING_RECEIVED_MAX);
+		pollEvents = state.events & POLLOUT;
+		wantPoll = (!state.pollIdle && (pollEvents || !(state.events & POLLIN)));
+	}
+
+	if (wantRead && !state.readArmed)
+		arm(fd, state, true);
+	else if (!wantRead && state.readArmed && !state.readCancelled)
+	{
+		cancel(toUserData(state.role == URING_LISTENER ? URING_OP_ACCEPT : URING_OP_RECV, state.readSeq, fd));
+		state.readCancelled = true;
+	}
+	if (state.pollArmed && (!wantPoll || state.pollEvents != pollEvents))
+	{
+		cancel(toUserData(URING_OP_POLL, state.pollSeq, fd));
+		state.pollArmed = false;
+	}
+	if (wantPoll && !state.pollArmed)
+	{
+		state.pollEvents = pollEvents;
+		arm(fd, state, false);
+	}
+}
+
+void	UringPoller::arm(int fd, s_uringFd &state, bool isRead)
+{
+	io_uring_sqe	*sqe = getSqe();
+	uint32_t		seq = _seqs[fd];
+
+	_seqs[fd] = (seq + 1) & URING_SEQ_MASK;
+	sqe->fd = fd;
+	if (!isRead)
+	{
+		sqe->opcode = IORING_OP_POLL_ADD;
+		sqe->poll32_events = state.pollEvents;
+		sqe->user_data = toUserData(URING_OP_POLL, seq, fd);
+		state.pollSeq = seq;
+		state.pollArmed = true;
+		return ;
+	}
+	if (state.role == URING_LISTENER)
+	{
+		sqe->opcode = IORING_OP_ACCEPT;
+		sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+		sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+		sqe->user_data = toUserData(URING_OP_ACCEPT, seq, fd);
+	}
+	else
+	{
+		sqe->opcode = IORING_OP_RECV;
+		sqe->ioprio = IORING_RECV_MULTISHOT;
+		sqe->flags = IOSQE_BUFFER_SELECT;
+		sqe->buf_group = URING_BUFFER_GROUP;
+		sqe->user_data = toUserData(URING_OP_RECV, seq, fd);
+	}
+	state.readSeq = seq;
+	state.readArmed = true;
+	state.readCancelled = false;
+}
+
+void	UringPoller::cancel(uint64_t userData)
+{
+	io_uring_sqe	*sqe = getSqe();
+
+	sqe->opcode = IORING_OP_ASYNC_CANCEL;
+	sqe->fd = -1;
+	sqe->addr = userData;
+	sqe->user_data = toUserData(URING_OP_CANCEL, 0, 0);
+}
+
+void	UringPoller::add(int fd, short events) { watch(fd, URING_READY, events); }
+void	UringPoller::addClient(int fd) { watch(fd, URING_CLIENT, POLLIN); }
+void	UringPoller::addListener(int fd) { watch(fd, URING_LISTENER, POLLIN); }
+
+void	UringPoller::modify(int fd, short events)
+{
+	if (fd >= static_cast<int>(_fds.size()) || _fds[fd].role == URING_UNWATCHED || _fds[fd].events == events)
+		return ;
+	_fds[fd].events = events;
+	_fds[fd].pollIdle = false;
+	markDirty(fd);
+}
+
+/**
+ * @brief Stops watching a FD: its requests are cancelled, what they completed and wasn't taken is dropped
+ * @note The cancellations go with the next io_uring_enter(): until then the socket stays open in the kernel.
+ */
+void	UringPoller::remove(int fd)
+{
+	if (fd >= static_cast<int>(_fds.size()) || _fds[fd].role == URING_UNWATCHED)
+		return ;
+
+	s_uringFd	&state = _fds[fd];
+
+	if (state.readArmed && !state.readCancelled)
+		cancel(toUserData(state.role == URING_LISTENER ? URING_OP_ACCEPT : URING_OP_RECV, state.readSeq, fd));
+	if (state.pollArmed)
+		cancel(toUserData(URING_OP_POLL, state.pollSeq, fd));
+	for (size_t i = 0; i < state.accepted.size(); i++)
+		if (state.accepted[i] >= 0)
+			close(state.accepted[i]);
+	state.role = URING_UNWATCHED;
+	state.readArmed = false;
+	state.pollArmed = false;
+	state.received.clear();
+	state.offset = 0;
+	state.accepted.clear();
+	_waiting.erase(fd);
+	_revents[fd] = 0;
+}
+
+/**
+ * @brief FDs whose data or sockets wait to be taken are reported again at each wait(),
+ * as a level-triggered engine would (a paused client only for an error)
+ */
+void	UringPoller::reportWaiting(std::vector<int> &reports)
+{
+	std::set<int>::iterator	it = _waiting.begin();
+
+	reports.clear();
+	while (it != _waiting.end())
+	{
+		s_uringFd	&state = _fds[*it];
+		bool		isWaiting = (state.role == URING_LISTENER ? !state.accepted.empty()
+			: state.role == URING_CLIENT && (state.received.size() > state.offset || state.eof || state.error));
+
+		if (!isWaiting)
+			_waiting.erase(it++);
+		else
+		{
+			if ((state.events & POLLIN) || state.error)
+				reports.push_back(*it);
+			++it;
+		}
+	}
+}
+
+/**
+ * @brief Arms or cancels what changed since the last call, then submits and waits for completions
+ * in a single syscall
+ *
+ * @return number of ready FDs
+ * @note Doesn't wait if completions or data not taken yet are already there.
+ */
+int	UringPoller::wait(int timeout)
+{
+	std::vector<int>	waiting;
+
+	_ready.clear();
+	for (size_t i = 0; i < _dirty.size(); i++)
+		update(_dirty[i]);
+	_dirty.clear();
+	reportWaiting(waiting);
+	submit((_completed.empty() && waiting.empty()) ? 1 : 0, timeout);
+	reap();
+
+	for (size_t i = 0; i < waiting.size(); i++)
+	{
+		s_uringFd	&state = _fds[waiting[i]];
+
+		report(waiting[i], ((state.events & POLLIN) ? POLLIN : 0) | (state.error ? POLLERR : 0));
+	}
+	for (size_t i = 0; i < _completed.size(); i++)
+	{
+		int		fd = _completed[i];
+		pollfd	ready;
+
+		if (_revents[fd] == 0)
+			continue ;
+		ready.fd = fd;
+		ready.events = 0;
+		ready.revents = _revents[fd];
+		_revents[fd] = 0;
+		_ready.push_back(ready);
+	}
+	_completed.clear();
+	return (_ready.size());
+}
+
+/**
+ * @brief Takes a socket completed by the multishot accept of the server socket
+ */
+int	UringPoller::accept(int fd, sockaddr_in &addr)
+{
+	if (fd >= static_cast<int>(_fds.size()) || _fds[fd].role != URING_LISTENER)
+		return (Poller::accept(fd, addr));
+
+	s_uringFd	&state = _fds[fd];
+
+	if (state.accepted.empty())
+	{
+		errno = EAGAIN;
+		return (ERROR);
+	}
+
+	int	clientFd = state.accepted.front();
+
+	state.accepted.pop_front();
+	if (!state.readArmed)
+		markDirty(fd);
+	if (clientFd < 0)
+	{
+		errno = -clientFd;
+		return (ERROR);
+	}
+
+	socklen_t	len = sizeof(addr);
+
+	memset(&addr, 0, sizeof(addr));
+	getpeername(clientFd, reinterpret_cast<sockaddr *>(&addr), &len);
+	return (clientFd);
+}
+
+/**
+ * @brief Reads the data completed by the multishot recv of a client
+ * @return as recv(): bytes read, 0 at the end of the stream, or ERROR with errno set (EAGAIN if nothing waits)
+ */
+ssize_t	UringPoller::receive(int fd, char *buffer, size_t len)
+{
+	if (fd >= static_cast<int>(_fds.size()) || _fds[fd].role != URING_CLIENT)
+		return (Poller::receive(fd, buffer, len));
+
+	s_uringFd	&state = _fds[fd];
+	size_t		available = state.received.size() - state.offset;
+
+	if (available > 0)
+	{
+		len = std::min(len, available);
+		memcpy(buffer, state.received.data() + state.offset, len);
+		state.offset += len;
+		if (state.offset == state.received.size())
+		{
+			state.received.clear();
+			state.offset = 0;
+		}
+		if (!state.readArmed)
+			markDirty(fd);
+		return (len);
+	}
+	if (state.error)
+	{
+		errno = state.error;
+		return (ERROR);
+	}
+	if (state.eof)
+		return (0);
+	errno = EAGAIN;
+	return (ERROR);
+}
+
+size_t	UringPoller::getReceived(int fd) const
+{
+	if (fd >= static_cast<int>(_fds.size()) || _fds[fd].role != URING_CLIENT)
+		return (0);
+	return (_fds[fd].received.size() - _fds[fd].offset);
+}
+
+/**
+ * @brief One SENDMSG request per client, submitted together: the sends of a loop turn cost
+ * a single io_uring_enter()
+ * @note The requests don't block (MSG_DONTWAIT) so they complete inline, the other completions
+ * reaped meanwhile are reported by the next wait().
+ */
+void	UringPoller::send(std::vector<s_send> &batch, size_t count)
+{
+	if (count == 0)
+		return ;
+	_batch = &batch;
+	_sendsLeft = count;
+	for (size_t i = 0; i < count; i++)
+	{
+		io_uring_sqe	*sqe = getSqe();
+
+		sqe->opcode = IORING_OP_SENDMSG;
+		sqe->fd = batch[i].fd;
+		sqe->addr = reinterpret_cast<uint64_t>(&batch[i].msg);
+		sqe->len = 1;
+		sqe->msg_flags = MSG_DONTWAIT | MSG_NOSIGNAL;
+		sqe->user_data = toUserData(URING_OP_SEND, 0, i);
+	}
+	while (_sendsLeft > 0)
+	{
+		submit(_sendsLeft, -1);
+		reap();
+	}
+	_batch = NULL;
+}
+
+std::string	UringPoller::getName() const { return ("io_uring"); }
+/* #endregion */
@@ -0,0 +1,763 @@
+#include "ft_irc.hpp"
+
+// Reactor whose loop runs in the calling thread (NULL out of the loops)
+static __thread Reactor	*currentReactor = NULL;
+
+/* #region Constructor/Destructor */
+
+/**
+ * @brief Creates the event loop, it is started by run() or spawn()
+ *
+ * @param id index of the Reactor, 0 is the one running in the main thread
+ * @param engine event loop engine ("io_uring", "epoll" or "poll")
+ */
+Reactor::Reactor(Server *server, int id, std::string const &engine):
+	_server(server), _id(id), _poller(NULL), _wakeFd(ERROR), _timerFd(ERROR), _clock(0), _threaded(false), _started(false), _running(false)
+{
+	itimerspec	spec;
+
+	_poller = Poller::create(engine);
+	if ((_wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) == ERROR)
+	{
+		delete _poller;
+		throw std::runtime_error("unable to create eventfd: " + std::string(strerror(errno)));
+	}
+
+	// periodic timer, each expiration is a tick of the wheel
+	memset(&spec, 0, sizeof(spec));
+	spec.it_value.tv_sec = TICK_INTERVAL;
+	spec.it_interval.tv_sec = TICK_INTERVAL;
+	if ((_timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)) == ERROR
+		|| timerfd_settime(_timerFd, 0, &spec, NULL) == ERROR)
+	{
+		std::string	error = strerror(errno);
+
+		if (_timerFd != ERROR)
+			close(_timerFd);
+		close(_wakeFd);
+		delete _poller;
+		throw std::runtime_error("unable to create timerfd: " + error);
+	}
+	pthread_mutex_init(&_inboxMutex, NULL);
+	_poller->add(_wakeFd, POLLIN);
+	_poller->add(_timerFd, POLLIN);
+}
+
+Reactor::~Reactor()
+{
+	join();
+	pthread_mutex_destroy(&_inboxMutex);
+	close(_wakeFd);
+	close(_timerFd);
+	delete _poller;
+}
+/* #endregion */
+
+/* #region PUBLIC */
+
+/**
+ * @brief Runs the event loop in the calling thread, until stop()
+ */
+void	Reactor::run()
+{
+	_started = true;
+	loop();
+}
+
+/**
+ * @brief Runs the event loop in a new thread
+ * @note Must be called once the signals are blocked, so that the thread inherits the mask.
+ */
+void	Reactor::spawn()
+{
+	if (pthread_create(&_thread, NULL, routine, this) != 0)
+		throw std::runtime_error("unable to create event loop thread");
+	_threaded = true;
+	_started = true;
+}
+
+/**
+ * @brief Waits for the end of the thread started by spawn()
+ * @note Once every thread is stopped, the calling thread owns the clients again.
+ */
+void	Reactor::join()
+{
+	if (_threaded)
+		pthread_join(_thread, NULL);
+	_threaded = false;
+	_started = false;
+}
+
+/**
+ * @brief Asks the event loop to stop (from any thread)
+ */
+void	Reactor::stop()
+{
+	if (isOwnThread())
+		_running = false;
+	else
+		post(POST_STOP, ERROR, NULL);
+}
+
+/**
+ * @brief Watches a FD that doesn't belong to a client (server socket, signals...),
+ * its events are given to the Server
+ */
+void	Reactor::watch(int fd) { _poller->add(fd, POLLIN); }
+
+/**
+ * @brief Watches the server socket, its connections are taken with accept()
+ */
+void	Reactor::watchListener(int fd) { _poller->addListener(fd); }
+
+/**
+ * @brief Takes a connection waiting on the server socket (see Poller::accept())
+ */
+int		Reactor::accept(int fd, sockaddr_in &addr) { return (_poller->accept(fd, addr)); }
+
+/**
+ * @brief Gives a newly accepted client to this Reactor, its registration deadline starts
+ */
+void	Reactor::adopt(User *user)
+{
+	if (!isOwnThread())
+		return (post(POST_ADOPT, user->getSocketFd(), user));
+
+	s_keepalive	&keepalive = user->getKeepalive();
+
+	keepalive.connectedAt = _wheel.getNow();
+	keepalive.lastActivity = _wheel.getNow();
+	keepalive.hasPartialLine = false;
+	keepalive.pingSent = false;
+	_clients[user->getSocketFd()] = user;
+	_poller->addClient(user->getSocketFd());
+	armTimeout(user);
+}
+
+/**
+ * @brief Forgets a client being disconnected (from its own thread)
+ */
+void	Reactor::release(int fd)
+{
+	User	*user = getClient(fd);
+
+	if (user != NULL)
+		_wheel.cancel(user->getKeepalive().timer);
+	_poller->remove(fd);
+	_clients.erase(fd);
+	_pendingInput.erase(fd);
+	_evictions.erase(fd);
+	_paused.erase(fd);
+}
+
+/**
+ * @brief Watches (or stops watching) when a client's socket is writable
+ *
+ * @param fd client's socket
+ * @param enable true while the client has messages queued
+ */
+void	Reactor::watchOutput(int fd, bool enable)
+{
+	_poller->modify(fd, (_paused.count(fd) ? 0 : POLLIN) | (enable ? POLLOUT : 0));
+}
+
+/**
+ * @brief A message has been queued for a client, its queue will be sent at the end of the loop turn
+ * @note Called with the client's SendQ lock held, from any thread.
+ */
+void	Reactor::scheduleFlush(int fd)
+{
+	if (isOwnThread())
+		_toFlush.push_back(fd);
+	else
+		post(POST_FLUSH, fd, NULL);
+}
+
+/**
+ * @brief The client will be disconnected at the end of the loop turn (see handleEvictions())
+ */
+void	Reactor::evict(int fd)
+{
+	if (isOwnThread())
+		_evictions.insert(fd);
+	else
+		post(POST_EVICT, fd, NULL);
+}
+
+/**
+ * @brief The client can take lines again (registration ended, or room in its Executor's queue)
+ */
+void	Reactor::resumeInput(int fd)
+{
+	if (isOwnThread())
+		restartInput(fd);
+	else
+		post(POST_INPUT, fd, NULL);
+}
+
+/**
+ * @brief Exempts a client from flood control, or not anymore (Server's lock held, from any thread)
+ */
+void	Reactor::setFloodExempt(User *user, bool exempt)
+{
+	if (!isOwnThread())
+		return (post(exempt ? POST_EXEMPT : POST_UNEXEMPT, user->getSocketFd(), user));
+
+	// the FD may belong to a newer client if the post came after a disconnection
+	if (getClient(user->getSocketFd()) == user)
+		user->getFlood().exempt = exempt;
+}
+
+/**
+ * @brief true in the thread running this Reactor, or in the main thread when no loop is running
+ */
+bool	Reactor::isOwnThread() const { return (currentReactor == this || (currentReactor == NULL && !_started)); }
+
+int			Reactor::getId() const { return (_id); }
+unsigned long	Reactor::getClock() const { return (_clock); }
+std::string	Reactor::getEngineName() const { return (_poller->getName()); }
+
+/* #endregion */
+
+/* #region PRIVATE */
+
+void	*Reactor::routine(void *reactor)
+{
+	Reactor	*self = static_cast<Reactor *>(reactor);
+
+	try
+	{
+		self->loop();
+	}
+	catch (std::exception const &e)
+	{
+		MSG_ERR(e.what());
+		self->_server->shutdown();
+	}
+	return (NULL);
+}
+
+/**
+ * @brief Waits for events and dispatches them
+ * @note Only the FDs with events are visited, whatever the number of clients.
+ * @note Clients that used their whole budget during the previous turn are served again
+ * even without new events, and the loop doesn't sleep while some are waiting.
+ * @note Turn pipeline: read -> parse -> execute -> flush. Replies are only sent at the end,
+ * with one syscall per client.
+ */
+void	Reactor::loop()
+{
+	currentReactor = this;
+	_running = true;
+	while (_running)
+	{
+		std::set<int>	pending;
+
+		pending.swap(_pendingInput);
+		_poller->wait(pending.empty() ? TIMEOUT : 0);
+		updateClock();
+
+		std::vector<pollfd> const	&ready = _poller->getReady();
+		for (size_t i = 0; i < ready.size() && _running; i++)
+		{
+			int	fd = ready[i].fd;
+
+			if (fd == _wakeFd)
+				handleInbox();
+			else if (fd == _timerFd)
+				handleTimer();
+			else if (_clients.find(fd) == _clients.end())
+				_server->handleServerEvent(fd);
+			else
+			{
+				if (ready[i].revents & (POLLIN | POLLERR | POLLHUP))
+				{
+					pending.erase(fd);
+					// reported even while paused: the connection is over, it won't be read again
+					if (_paused.count(fd) && (ready[i].revents & (POLLERR | POLLHUP)))
+						handleHangup(getClient(fd));
+					else
+						handleIncomingData(fd);
+				}
+				if (ready[i].revents & POLLOUT)
+					handleOutgoingData(fd);
+			}
+		}
+		for (std::set<int>::iterator it = pending.begin(); it != pending.end() && _running; it++)
+			handleIncomingData(*it);
+		flushClients();
+	}
+	currentReactor = NULL;
+}
+
+/**
+ * @brief Adds an operation to the inbox and wakes the event loop up
+ */
+void	Reactor::post(postType type, int fd, User *user)
+{
+	s_post		op;
+	uint64_t	one = 1;
+
+	op.type = type;
+	op.fd = fd;
+	op.user = user;
+
+	Lock	lock(_inboxMutex);
+	_inbox.push_back(op);
+	if (_inbox.size() == 1 && write(_wakeFd, &one, sizeof(one)) == ERROR)
+		MSG_ERR(strerror(errno));
+}
+
+/**
+ * @brief Handles the operations posted by the other threads, in order
+ */
+void	Reactor::handleInbox()
+{
+	std::vector<s_post>	inbox;
+	uint64_t			count;
+
+	{
+		Lock	lock(_inboxMutex);
+		inbox.swap(_inbox);
+		if (read(_wakeFd, &count, sizeof(count)) == ERROR && errno != EAGAIN)
+			MSG_ERR(strerror(errno));
+	}
+	for (std::vector<s_post>::iterator it = inbox.begin(); it != inbox.end(); it++)
+	{
+		switch (it->type)
+		{
+			case POST_ADOPT:	adopt(it->user); break ;
+			case POST_FLUSH:	_toFlush.push_back(it->fd); break ;
+			case POST_EVICT:	_evictions.insert(it->fd); break ;
+			case POST_INPUT:	restartInput(it->fd); break ;
+			case POST_EXEMPT:	setFloodExempt(it->user, true); break ;
+			case POST_UNEXEMPT:	setFloodExempt(it->user, false); break ;
+			case POST_STOP:		_running = false; break ;
+		}
+	}
+}
+
+/**
+ * @brief Moves the wheel by the number of timer expirations, and handles the clients
+ * whose deadline came
+ */
+void	Reactor::handleTimer()
+{
+	uint64_t			expirations;
+	std::vector<int>	expired;
+
+	if (read(_timerFd, &expirations, sizeof(expirations)) != sizeof(expirations))
+		return ;
+	_wheel.advance(expirations, expired);
+	if (expired.empty())
+		return ;
+
+	ServerLock	lock(_server->getLock());
+	for (std::vector<int>::iterator it = expired.begin(); it != expired.end(); it++)
+	{
+		User	*user = getClient(*it);
+
+		if (user != NULL && !user->isDisconnecting())
+			handleTimeout(user);
+	}
+}
+
+/**
+ * @brief The client's timer fired (lock held): disconnects it if a deadline is over,
+ * sends a keepalive PING after PING_INTERVAL of silence, then arms the next deadline
+ *
+ * @note - registration must be done within REGISTRATION_TIMEOUT
+ * @note - a partial line must be completed within LINE_TIMEOUT (slowloris)
+ * @note - the PING must be answered within PING_TIMEOUT (any data counts as an answer)
+ * @note - a throttled client must not have more than FLOOD_RECVQ_MAX bytes waiting,
+ * it is read again once its penalty went down
+ * @note Received data only updates lastActivity: the timer isn't moved for each read,
+ * it is re-armed here when it fires too early.
+ */
+void	Reactor::handleTimeout(User *user)
+{
+	s_keepalive		&keepalive = user->getKeepalive();
+	s_flood			&flood = user->getFlood();
+	unsigned long	now = _wheel.getNow();
+	std::string		why;
+
+	// still flooding: disconnected by throttleLocked()
+	if (flood.throttled && isExcessFlood(user))
+		return (throttleLocked(user));
+	if (user->getStatus() != REGISTERED && now - keepalive.connectedAt >= REGISTRATION_TIMEOUT / TICK_INTERVAL)
+		why = MSG_CLT_REGISTRATION_TIMEOUT;
+	else if (keepalive.hasPartialLine && now - keepalive.partialSince >= LINE_TIMEOUT / TICK_INTERVAL)
+		why = MSG_CLT_LINE_TIMEOUT;
+	else if (keepalive.pingSent && now - keepalive.pingSentAt >= PING_TIMEOUT / TICK_INTERVAL)
+		why = MSG_CLT_PING_TIMEOUT;
+	if (!why.empty())
+	{
+		msg_log(MSG_CLT_TIMEOUT(user->getSocketFd(), why));
+		user->sendToClient(SEND_ERROR(user->getHostname(), why));
+		user->setLeavingMessage(why);
+		_server->disconnectClient(user);
+		return ;
+	}
+
+	if (!keepalive.pingSent && now - keepalive.lastActivity >= PING_INTERVAL / TICK_INTERVAL)
+	{
+		user->sendToClient(SEND_PING);
+		keepalive.pingSent = true;
+		keepalive.pingSentAt = now;
+	}
+
+	// penalty went down: lines waiting are handled next turn (paused again if still flooding)
+	if (flood.throttled && now >= flood.resumeAt)
+	{
+		flood.throttled = false;
+		restartInput(user->getSocketFd());
+	}
+	armTimeout(user);
+}
+
+/**
+ * @brief Arms the client's timer at its next deadline
+ */
+void	Reactor::armTimeout(User *user)
+{
+	s_keepalive		&keepalive = user->getKeepalive();
+	unsigned long	next;
+
+	if (keepalive.pingSent)
+		next = keepalive.pingSentAt + PING_TIMEOUT / TICK_INTERVAL;
+	else
+		next = keepalive.lastActivity + PING_INTERVAL / TICK_INTERVAL;
+	if (user->getStatus() != REGISTERED)
+		next = std::min(next, keepalive.connectedAt + REGISTRATION_TIMEOUT / TICK_INTERVAL);
+	if (keepalive.hasPartialLine)
+		next = std::min(next, keepalive.partialSince + LINE_TIMEOUT / TICK_INTERVAL);
+	if (user->getFlood().throttled)
+		next = std::min(next, user->getFlood().resumeAt);
+	_wheel.arm(keepalive.timer, next);
+}
+
+/**
+ * @brief Starts the line deadline when the client's buffer ends with an incomplete line
+ * @note Without the Server's lock: the timer is only brought forward, the other
+ * deadlines are checked when it fires.
+ */
+void	Reactor::trackPartialLine(User *user)
+{
+	s_keepalive	&keepalive = user->getKeepalive();
+	LineBuffer	&input = user->getInput();
+	bool		hasPartialLine = input.size() > 0 && !input.hasLine();
+
+	if (hasPartialLine && !keepalive.hasPartialLine)
+	{
+		unsigned long	deadline = _wheel.getNow() + LINE_TIMEOUT / TICK_INTERVAL;
+
+		keepalive.partialSince = _wheel.getNow();
+		if (keepalive.timer.expires > deadline)
+			_wheel.arm(keepalive.timer, deadline);
+	}
+	keepalive.hasPartialLine = hasPartialLine;
+}
+
+/**
+ * @brief Handle when POLLIN detected in a client
+ *
+ * @param clientfd client's socket FD
+ * @note Reads until EAGAIN in the client's own buffer and handles every complete line,
+ * within RECV_BUDGET bytes and LINES_BUDGET lines. What is left (in the socket or
+ * in the buffer) will be handled during the next loop turns.
+ * @note Reads don't hold the Server's lock. A client that can't take more lines
+ * isn't watched until it is resumed (see resumeInput()).
+ */
+void	Reactor::handleIncomingData(int clientfd)
+{
+	User	*user = getClient(clientfd);
+
+	// client was disconnected earlier during this loop, or is paused
+	if (user == NULL || _paused.count(clientfd))
+		return ;
+
+	LineBuffer	&input = user->getInput();
+	int			linesBudget = LINES_BUDGET;
+	size_t		bytesBudget = RECV_BUDGET;
+	bool		stalled = false;
+
+	while (true)
+	{
+		// lines left from the previous turn first, then the ones just received
+		if (!handleLines(user, linesBudget, stalled))
+			return ;
+		if (stalled)
+			return (pauseInput(user));
+		if (linesBudget == 0 || bytesBudget == 0)
+			break ;
+
+		char	*space = input.prepare();
+		if (input.space() == 0)
+			break ;
+
+		int		bytesReceived = _poller->receive(clientfd, space, std::min(input.space(), bytesBudget));
+		if (bytesReceived > 0)
+		{
+			input.commit(bytesReceived);
+			bytesBudget -= bytesReceived;
+
+			// the client is alive, a keepalive PING is answered
+			user->getKeepalive().lastActivity = _wheel.getNow();
+			user->getKeepalive().pingSent = false;
+		}
+		else if (bytesReceived == ERROR && (errno == EAGAIN || errno == EWOULDBLOCK))
+			break ;
+		else if (bytesReceived == ERROR && errno == EINTR)
+			continue ;
+		else
+			return (handleHangup(user));
+	}
+
+	// budget is spent but lines are waiting
+	if (input.hasLine())
+		_pendingInput.insert(clientfd);
+	trackPartialLine(user);
+}
+
+/**
+ * @brief The client's connection is closed or broken: disconnects it
+ * @note Commands received before the end of the connection go first (QUIT message).
+ * @note Also called for a paused client: POLLHUP and POLLERR are reported whatever
+ * the events watched, and would be reported again every loop turn.
+ */
+void	Reactor::handleHangup(User *user)
+{
+	ServerLock	lock(_server->getLock());
+	Executor	*executor = _server->getExecutor();
+
+	if (executor == NULL || executor->drain(user))
+		_server->disconnectClient(user);
+}
+
+/**
+ * @brief Executes the complete lines of the client's buffer, or gives them to the Executor
+ *
+ * @param linesBudget max number of lines to handle, decreased for each line
+ * @param stalled set to true if the client can't take more lines for now
+ * @return false if the client has been disconnected (or will be at the end of the loop turn)
+ * @note With the Executor, lines are framed and parsed without the Server's lock.
+ */
+bool	Reactor::handleLines(User *user, int &linesBudget, bool &stalled)
+{
+	Executor	*executor = _server->getExecutor();
+
+	if (executor == NULL)
+	{
+		ServerLock	lock(_server->getLock());
+
+		if (user->isDisconnecting() || !_server->executeLines(user, linesBudget))
+			return (false);
+
+		// lines after registration (or a NICK claimed to the Supervisor) wait until it ends, or until the penalty goes down
+		stalled = (user->isWaiting() && user->getInput().hasLine()) || user->getFlood().throttled;
+		return (true);
+	}
+
+	int	budget = std::min(linesBudget, executor->getRoom(user));
+	int	parsed = budget;
+
+	if (!_server->parseLines(user, budget, _commands))
+	{
+		ServerLock	lock(_server->getLock());
+
+		_commands.clear();
+		_server->disconnectClient(user);
+		return (false);
+	}
+	linesBudget -= parsed - budget;
+
+	// queue is full until the Executor catches up, or penalty is too high
+	stalled = executor->submit(user, _commands) || user->getFlood().throttled;
+	return (true);
+}
+
+/**
+ * @brief Stops watching the client's input, until restartInput()
+ */
+void	Reactor::pauseInput(User *user)
+{
+	_paused.insert(user->getSocketFd());
+	_poller->modify(user->getSocketFd(), user->isOutputWatched() ? POLLOUT : 0);
+	if (user->getFlood().throttled)
+		throttle(user);
+}
+
+/**
+ * @brief throttleLocked() from the read path, which doesn't hold the Server's lock
+ */
+void	Reactor::throttle(User *user)
+{
+	ServerLock	lock(_server->getLock());
+
+	throttleLocked(user);
+}
+
+/**
+ * @brief The client's penalty is too high: its lines wait in the buffers until its timer
+ * fires (see handleTimeout()), or it is disconnected if too much is waiting
+ * @note The Server's lock must be held (the lock isn't recursive).
+ */
+void	Reactor::throttleLocked(User *user)
+{
+	s_flood			&flood = user->getFlood();
+	s_keepalive		&keepalive = user->getKeepalive();
+	unsigned long	resume = flood.penaltyUntil - FLOOD_BURST;	// clock at which a line can be executed again
+	unsigned long	wait = resume > _clock ? resume - _clock : 0;
+	unsigned long	tickMs = TICK_INTERVAL * 1000;
+
+	if (isExcessFlood(user))
+	{
+		msg_log(MSG_CLT_FLOODED(user->getSocketFd()));
+		user->sendToClient(SEND_ERROR(user->getHostname(), MSG_CLT_EXCESS_FLOOD));
+		user->setLeavingMessage(MSG_CLT_EXCESS_FLOOD);
+		_server->disconnectClient(user);
+		return ;
+	}
+	flood.resumeAt = _wheel.getNow() + std::max((wait + tickMs - 1) / tickMs, 1UL);
+	if (keepalive.timer.expires > flood.resumeAt)
+		_wheel.arm(keepalive.timer, flood.resumeAt);
+}
+
+/**
+ * @brief Whether a throttled client has more than FLOOD_RECVQ_MAX bytes waiting
+ * (in its buffer, in its socket and received by the Poller)
+ */
+bool	Reactor::isExcessFlood(User *user)
+{
+	int	waiting = 0;
+
+	if (ioctl(user->getSocketFd(), FIONREAD, &waiting) == ERROR)
+		waiting = 0;
+	return (user->getInput().size() + waiting + _poller->getReceived(user->getSocketFd()) > FLOOD_RECVQ_MAX);
+}
+
+/**
+ * @brief Reads the monotonic clock once per loop turn (flood control)
+ */
+void	Reactor::updateClock()
+{
+	timespec	now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	_clock = now.tv_sec * 1000UL + now.tv_nsec / 1000000;
+}
+
+/**
+ * @brief Watches the client's input again, lines already received are handled next turn
+ */
+void	Reactor::restartInput(int fd)
+{
+	User	*user = getClient(fd);
+
+	if (user == NULL)
+		return ;
+	_pendingInput.insert(fd);
+	if (_paused.erase(fd))
+		_poller->modify(fd, POLLIN | (user->isOutputWatched() ? POLLOUT : 0));
+}
+
+/**
+ * @brief Handle when POLLOUT detected in a client: its queued messages are sent with
+ * the other clients' ones at the end of the loop turn
+ *
+ * @param clientfd client's socket FD
+ */
+void	Reactor::handleOutgoingData(int clientfd)
+{
+	if (getClient(clientfd) != NULL)
+		_toFlush.push_back(clientfd);
+}
+
+/**
+ * @brief Disconnects the clients that exceeded their SendQ limit, or that sent QUIT
+ * to the Executor, during this loop turn
+ * @note Done once every event is handled, so that no User is deleted while a command
+ * or a channel is still using it. Their QUIT can evict other clients, which are
+ * disconnected too.
+ * @note The FD may belong to a newer client if the eviction was posted before
+ * the disconnection of the previous one, hence the isDisconnecting() check.
+ */
+void	Reactor::handleEvictions()
+{
+	while (!_evictions.empty())
+	{
+		User	*user = getClient(*_evictions.begin());
+
+		_evictions.erase(_evictions.begin());
+		if (user == NULL || !user->isDisconnecting())
+			continue ;
+		if (user->isEvicted())
+			user->setLeavingMessage(MSG_CLT_SENDQ_EXCEEDED);
+		_server->disconnectClient(user);
+	}
+}
+
+/**
+ * @brief Sends what has been queued for each client during the loop turn, then
+ * disconnects the broken connections and the evicted clients
+ * @note The sends of every client are given to the Poller together (a single syscall
+ * with io_uring). Their SendQs stay locked from User::beginFlush() to User::endFlush():
+ * only this thread locks several of them.
+ * @note The sends don't take the Server's lock, so the Executor's shared commands keep
+ * running meanwhile; it is only taken for the disconnections.
+ * @note Disconnections queue QUIT messages for other clients, which are sent too.
+ */
+void	Reactor::flushClients()
+{
+	while (!_toFlush.empty() || !_evictions.empty())
+	{
+		std::vector<int>	toFlush;
+		std::vector<User *>	flushed;
+		std::vector<int>	broken;
+
+		toFlush.swap(_toFlush);
+		std::sort(toFlush.begin(), toFlush.end());
+		toFlush.erase(std::unique(toFlush.begin(), toFlush.end()), toFlush.end());
+		if (_sends.size() < toFlush.size())
+			_sends.resize(toFlush.size());
+		for (std::vector<int>::iterator it = toFlush.begin(); it != toFlush.end(); it++)
+		{
+			User	*user = getClient(*it);
+
+			if (user != NULL && user->beginFlush(_sends[flushed.size()]))
+				flushed.push_back(user);
+		}
+		_poller->send(_sends, flushed.size());
+		for (size_t i = 0; i < flushed.size(); i++)
+			if (!flushed[i]->endFlush(_sends[i]))
+				broken.push_back(flushed[i]->getSocketFd());
+		if (broken.empty() && _evictions.empty())
+			continue ;
+
+		ServerLock	lock(_server->getLock());
+		for (std::vector<int>::iterator it = broken.begin(); it != broken.end(); it++)
+		{
+			User	*user = getClient(*it);
+
+			if (user != NULL)
+				_server->disconnectClient(user);
+		}
+		handleEvictions();
+	}
+}
+
+/**
+ * @brief Search a client of this Reactor with his socket FD
+ *
+ * @return NULL if not found or a pointer to the User if found
+ */
+User	*Reactor::getClient(int fd)
+{
+	std::map<int, User *>::iterator	it = _clients.find(fd);
+
+	if (it == _clients.end())
+		return (NULL);
+	return (it->second);
+}
+
+/* #endregion */
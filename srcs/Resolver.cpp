@@ -0,0 +1,181 @@
+#include "ft_irc.hpp"
+
+/* #region Constructor/Destructor */
+
+/**
+ * @brief Starts the resolution threads
+ *
+ * @param nbOfThreads number of getnameinfo() that can run at the same time
+ * @note Must be created once the signals are blocked, so that threads inherit the mask.
+ */
+Resolver::Resolver(int nbOfThreads): _stop(false)
+{
+	if ((_notifyFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) == ERROR)
+		throw std::runtime_error("unable to create eventfd: " + std::string(strerror(errno)));
+	pthread_mutex_init(&_mutex, NULL);
+	pthread_cond_init(&_cond, NULL);
+	for (int i = 0; i < nbOfThreads; i++)
+	{
+		pthread_t	thread;
+
+		if (pthread_create(&thread, NULL, routine, this) != 0)
+		{
+			stopThreads();
+			throw std::runtime_error("unable to create resolver thread");
+		}
+		_threads.push_back(thread);
+	}
+}
+
+Resolver::~Resolver()
+{
+	stopThreads();
+	pthread_cond_destroy(&_cond);
+	pthread_mutex_destroy(&_mutex);
+	close(_notifyFd);
+}
+/* #endregion */
+
+/* #region PUBLIC */
+
+/**
+ * @brief Searchs the hostname of an address in the cache
+ *
+ * @return false if the address is unknown or expired
+ */
+bool	Resolver::lookup(in_addr const &addr, std::string &hostname)
+{
+	std::map<in_addr_t, std::list<s_dnsEntry>::iterator>::iterator	it = _cacheIndex.find(addr.s_addr);
+
+	if (it == _cacheIndex.end())
+		return (false);
+	if (it->second->expiration < time(NULL))
+	{
+		_cache.erase(it->second);
+		_cacheIndex.erase(it);
+		return (false);
+	}
+	_cache.splice(_cache.begin(), _cache, it->second);
+	hostname = it->second->hostname;
+	return (true);
+}
+
+/**
+ * @brief Queues the resolution of a client's address
+ *
+ * @param fd client's socket, given back with the result
+ */
+void	Resolver::resolve(int fd, in_addr const &addr)
+{
+	pthread_mutex_lock(&_mutex);
+	_requests.push(std::make_pair(fd, addr));
+	pthread_cond_signal(&_cond);
+	pthread_mutex_unlock(&_mutex);
+}
+
+/**
+ * @brief Gets the results ready since last call, and stores them in the cache
+ */
+void	Resolver::collect(std::vector<s_dnsResult> &results)
+{
+	uint64_t	count;
+
+	if (read(_notifyFd, &count, sizeof(count)) != sizeof(count))
+		return ;
+	pthread_mutex_lock(&_mutex);
+	results.swap(_results);
+	pthread_mutex_unlock(&_mutex);
+	for (std::vector<s_dnsResult>::iterator it = results.begin(); it != results.end(); it++)
+		addToCache(*it);
+}
+
+int	Resolver::getNotifyFd() const { return (_notifyFd); }
+/* #endregion */
+
+/* #region PRIVATE */
+
+void	*Resolver::routine(void *resolver)
+{
+	static_cast<Resolver *>(resolver)->work();
+	return (NULL);
+}
+
+/**
+ * @brief Thread loop: resolves requests until the Resolver is destroyed
+ */
+void	Resolver::work()
+{
+	pthread_mutex_lock(&_mutex);
+	while (true)
+	{
+		while (_requests.empty() && !_stop)
+			pthread_cond_wait(&_cond, &_mutex);
+		if (_stop)
+			break ;
+
+		s_dnsResult	result;
+		sockaddr_in	addr;
+		char		hostname[NI_MAXHOST];
+
+		result.fd = _requests.front().first;
+		result.addr = _requests.front().second;
+		_requests.pop();
+		pthread_mutex_unlock(&_mutex);
+
+		// blocking resolution, out of the lock
+		memset(&addr, 0, sizeof(addr));
+		addr.sin_family = AF_INET;
+		addr.sin_addr = result.addr;
+		result.ip = inet_ntoa(result.addr);
+		if (getnameinfo((struct sockaddr *)&addr, sizeof(addr), hostname, NI_MAXHOST, NULL, 0, NI_NAMEREQD) == 0)
+			result.hostname = hostname;
+		else
+			result.hostname = result.ip;
+
+		uint64_t	one = 1;
+		pthread_mutex_lock(&_mutex);
+		_results.push_back(result);
+		if (write(_notifyFd, &one, sizeof(one)) == ERROR)
+			MSG_ERR(strerror(errno));
+	}
+	pthread_mutex_unlock(&_mutex);
+}
+
+void	Resolver::stopThreads()
+{
+	pthread_mutex_lock(&_mutex);
+	_stop = true;
+	pthread_cond_broadcast(&_cond);
+	pthread_mutex_unlock(&_mutex);
+	for (std::vector<pthread_t>::iterator it = _threads.begin(); it != _threads.end(); it++)
+		pthread_join(*it, NULL);
+	_threads.clear();
+}
+
+/**
+ * @brief Stores a result as most recently used, the least recently used entry is dropped if full
+ */
+void	Resolver::addToCache(s_dnsResult const &result)
+{
+	std::map<in_addr_t, std::list<s_dnsEntry>::iterator>::iterator	it = _cacheIndex.find(result.addr.s_addr);
+
+	if (it != _cacheIndex.end())
+	{
+		_cache.erase(it->second);
+		_cacheIndex.erase(it);
+	}
+	else if (_cache.size() >= DNS_CACHE_SIZE)
+	{
+		_cacheIndex.erase(_cache.back().addr);
+		_cache.pop_back();
+	}
+
+	s_dnsEntry	entry;
+
+	entry.addr = result.addr.s_addr;
+	entry.hostname = result.hostname;
+	entry.expiration = time(NULL) + DNS_CACHE_TTL;
+	_cache.push_front(entry);
+	_cacheIndex[entry.addr] = _cache.begin();
+}
+/* #endregion */
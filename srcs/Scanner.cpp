@@ -0,0 +1,123 @@
+#include "ft_irc.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+# include <immintrin.h>
+# ifdef __SSE2__
+#  define SCANNER_SSE2
+# endif
+# define SCANNER_AVX2		// compiled for its own target, only used if CPUID reports it
+#endif
+
+/* #region Scalar */
+
+static char const	*findByteScalar(char const *begin, char const *end, char c)
+{
+	while (begin != end && *begin != c)
+		begin++;
+	return (begin);
+}
+/* #endregion */
+
+/* #region SSE2 */
+#ifdef SCANNER_SSE2
+
+static char const	*findByteSse2(char const *begin, char const *end, char c)
+{
+	__m128i const	needle = _mm_set1_epi8(c);
+
+	for (; end - begin >= 16; begin += 16)
+	{
+		__m128i	chunk = _mm_loadu_si128(reinterpret_cast<__m128i const *>(begin));
+		int		mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle));
+
+		if (mask != 0)
+			return (begin + __builtin_ctz(mask));
+	}
+	return (findByteScalar(begin, end, c));
+}
+
+#endif
+/* #endregion */
+
+/* #region AVX2 */
+#ifdef SCANNER_AVX2
+
+__attribute__((target("avx2")))
+static char const	*findByteAvx2(char const *begin, char const *end, char c)
+{
+	__m256i const	needle = _mm256_set1_epi8(c);
+
+	for (; end - begin >= 32; begin += 32)
+	{
+		__m256i		chunk = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(begin));
+		unsigned	mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, needle));
+
+		if (mask != 0)
+			return (begin + __builtin_ctz(mask));
+	}
+# ifdef SCANNER_SSE2
+	return (findByteSse2(begin, end, c));
+# else
+	return (findByteScalar(begin, end, c));
+# endif
+}
+
+#endif
+/* #endregion */
+
+/* #region PRIVATE */
+
+/**
+ * @brief Picks the widest implementation the CPU runs (once, before main())
+ */
+Scanner::s_impl	Scanner::select()
+{
+	s_impl	impl = {"scalar", &findByteScalar};
+
+#ifdef SCANNER_SSE2
+	impl.name = "sse2";
+	impl.findByte = &findByteSse2;
+#endif
+#ifdef SCANNER_AVX2
+	// called before the constructors of the runtime: CPUID must be read first
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+	{
+		impl.name = "avx2";
+		impl.findByte = &findByteAvx2;
+	}
+#endif
+	return (impl);
+}
+
+Scanner::s_impl const	Scanner::_impl = Scanner::select();
+
+/* #endregion */
+
+/* #region PUBLIC */
+
+/**
+ * @brief Every implementation this CPU runs, the scalar one first (tests and benchmarks
+ * compare them, the server only uses the one picked by select())
+ */
+std::vector<Scanner::s_impl>	Scanner::getImpls()
+{
+	std::vector<s_impl>	impls;
+	s_impl				scalar = {"scalar", &findByteScalar};
+
+	impls.push_back(scalar);
+#ifdef SCANNER_SSE2
+	s_impl				sse2 = {"sse2", &findByteSse2};
+
+	impls.push_back(sse2);
+#endif
+#ifdef SCANNER_AVX2
+	s_impl				avx2 = {"avx2", &findByteAvx2};
+
+	if (__builtin_cpu_supports("avx2"))
+		impls.push_back(avx2);
+#endif
+	return (impls);
+}
+
+/* #endregion */
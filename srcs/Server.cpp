@@ -1,16 +1,5 @@
 #include "Server.hpp"
 
-/* #region Signal handling */
-bool	stopSignalReceived = false;
-
-void	handleSignal(int signal)
-{
-	(void)signal;
-	msg_log(MSG_SVR_EXIT_SIG);
-	stopSignalReceived = true;
-}
-/* #endregion */
-
 /* #region Contructor/Destructor */
 
 /**
@@ -20,8 +9,16 @@ void	handleSignal(int signal)
  * @param password password to allow you to connect to the server
  */
 Server::Server(std::string const &port, std::string const &password):
-	_password(password), _serverSocket(ERROR), _nbOfClients(0)
+	_password(password), _serverSocket(ERROR), _spareFd(ERROR), _nextReactor(0), _resolver(NULL), _executor(NULL), _bus(NULL), _signalFd(ERROR),
+	_nbOfClients(0)
 {
+	pthread_rwlockattr_t	attr;
+
+	// writers first: a stream of shared commands must not delay disconnections and timers
+	pthread_rwlockattr_init(&attr);
+	pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+	pthread_rwlock_init(&_lock, &attr);
+	pthread_rwlockattr_destroy(&attr);
 	setEndian();
 	setPort(port);
 	memset(&_addrServer, 0, sizeof(_addrServer));
@@ -36,12 +33,29 @@ Server::~Server()
 {
 	msg_log(MSG_SVR_SHUTDOWN);
 
-	// clear all users
+	// clear all users, then the clients of the other workers still in the channels
 	disconnectAllClients();
+	deleteRemoteUsers();
 
 	// clear all commands
 	deleteCommands(_commands);
 
+	// stop hostname resolution and commands execution
+	delete _resolver;
+	delete _executor;
+	delete _bus;
+
+	// close event loop FDs
+	if (_signalFd != ERROR)
+		close(_signalFd);
+	if (_serverSocket != ERROR)
+		close(_serverSocket);
+	if (_spareFd != ERROR)
+		close(_spareFd);
+	for (std::vector<Reactor *>::iterator it = _reactors.begin(); it != _reactors.end(); it++)
+		delete *it;
+	pthread_rwlock_destroy(&_lock);
+
 	msg_log(MSG_SVR_END);
 }
 /* #endregion */
@@ -95,9 +109,12 @@ void	Server::setEndian()
  * @brief Creation and configuration of the server's socket
  * @note - 1) in socket() : AF_INET for IPv4 protocol, SOCK_STREAM since we use TCP protocol, and 0 is because there is only one protocol available for UNIX domain.
  * @note - 2) in setsockopt() : Allow socket fd to be reusable and prevent it from blocking the port (https://beej.us/guide/bgnet/html/#getaddrinfoprepare-to-launch).
+ * Worker processes also set SO_REUSEPORT, each one has its own server socket on the same port.
  * @note - 3) IP addr setup: AF_INET for IPv4 protcol, INNADDR_ANY for listen on every available network interface.
  * @note - 4) The listening socket is set ton non blocking mode. Sockets from incoming connections will inherit this state.
  * @note - 5) When socket is created, it needs to be assigned a "name". Thats what bind() will do.
+ * @note - 6) TCP_DEFER_ACCEPT: the server socket is only ready when a client has sent its first data.
+ * @note - 8) The spare FD is released when accept() fails with EMFILE/ENFILE (see rejectConnection()).
  */
 void	Server::setServerSocket()
 {
@@ -112,6 +129,12 @@ void	Server::setServerSocket()
 		throw std::runtime_error("unable to configure socket to 'reusable'");
 	MSG_DEV(MSG_DEV_SVR_SOC_SETOPT, _serverSocket);
 
+	// 2b) worker processes share the port, the kernel spreads the connections
+	if (_bus && setsockopt(_serverSocket, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable)) == ERROR)
+		throw std::runtime_error("unable to configure socket to 'reusable port'");
+	if (_bus)
+		MSG_DEV(MSG_DEV_SVR_SOC_REUSEPORT, _serverSocket);
+
 	// 3) IP address/port setup
 	_addrServer.sin_family = AF_INET;
 	_addrServer.sin_addr.s_addr = INADDR_ANY;
@@ -131,194 +154,553 @@ void	Server::setServerSocket()
 		throw std::runtime_error(std::string("unable to bind server socket to address") + strerror(errno));
 	MSG_DEV(MSG_DEV_SVR_SOC_IPv4_BINDED, "");
 
-	// 6) Enabling listening mode for this socket
-	if (listen(_serverSocket, MAX_CLIENTS) == ERROR)
+	// 6) Connections are only accepted once the client has sent data
+	int	deferDelay = DEFER_ACCEPT;
+	if (setsockopt(_serverSocket, IPPROTO_TCP, TCP_DEFER_ACCEPT, &deferDelay, sizeof(deferDelay)) == ERROR)
+		MSG_ERR(strerror(errno));
+	MSG_DEV(MSG_DEV_SVR_SOC_DEFER, deferDelay);
+
+	// 7) Enabling listening mode for this socket
+	if (listen(_serverSocket, LISTEN_BACKLOG) == ERROR)
 		throw std::runtime_error("unable to enable listening mode for the server socket");
 	MSG_DEV(MSG_DEV_SVR_SOC_LISTEN, "");
+
+	// 8) FD kept in reserve to reject clients when no FD is left
+	_spareFd = open("/dev/null", O_RDONLY | O_CLOEXEC);
 }
 
 /**
- * @brief Checks the result of poll()
- * 
- * @param numEventsReady number of events "ready" that poll() returned
+ * @brief Blocks SIGINT and receives it through a signalfd instead
+ * @note The signal then comes as a POLLIN event in the main loop, no global flag is needed.
+ */
+void	Server::setSignalFd()
+{
+	sigset_t	mask;
+
+	sigemptyset(&mask);
+	sigaddset(&mask, SIGINT);
+	if (sigprocmask(SIG_BLOCK, &mask, NULL) == ERROR)
+		throw std::runtime_error("unable to block signals: " + std::string(strerror(errno)));
+	if ((_signalFd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC)) == ERROR)
+		throw std::runtime_error("unable to create signalfd: " + std::string(strerror(errno)));
+	addToPoll(_signalFd);
+}
+
+/**
+ * @brief Multi-process mode: PROCESSES by default, or the IRC_PROCESSES environment variable.
+ * With more than 1, the Supervisor forks the workers and this process only routes their messages.
+ *
+ * @return false in the Supervisor (workers are stopped), true in a worker or without multi-process mode
+ */
+bool	Server::setBus()
+{
+	char const	*processes = getenv("IRC_PROCESSES");
+	int			nbOfProcesses = processes ? std::atoi(processes) : PROCESSES;
+	int			busFd;
+	int			workerId;
+
+	if (nbOfProcesses < 1 || nbOfProcesses > PROCESSES_MAX)
+		throw std::invalid_argument("invalid number of worker processes: " + to_string(nbOfProcesses));
+	if (nbOfProcesses == 1)
+		return (true);
+	{
+		Supervisor	supervisor(nbOfProcesses);
+
+		busFd = supervisor.run();
+		workerId = supervisor.getWorkerId();
+	}
+	if (busFd == ERROR)
+		return (false);
+	_bus = new Bus(busFd, workerId, nbOfProcesses);
+	return (true);
+}
+
+/**
+ * @brief Creates the event loops: REACTORS by default, or the IRC_REACTORS environment variable
+ * @note The first one runs in the main thread, the others get their own thread in start().
+ */
+void	Server::setReactors()
+{
+	char const	*engine = getenv("IRC_ENGINE");
+	char const	*reactors = getenv("IRC_REACTORS");
+	int			nbOfReactors = reactors ? std::atoi(reactors) : REACTORS;
+
+	if (nbOfReactors < 1 || nbOfReactors > REACTORS_MAX)
+		throw std::invalid_argument("invalid number of event loop threads: " + to_string(nbOfReactors));
+	for (int i = 0; i < nbOfReactors; i++)
+		_reactors.push_back(new Reactor(this, i, engine ? engine : ENGINE));
+	MSG_DEV(MSG_DEV_SVR_ENGINE, _reactors[0]->getEngineName());
+	MSG_DEV(MSG_DEV_SVR_REACTORS, nbOfReactors);
+	MSG_DEV(MSG_DEV_SVR_SCANNER, Scanner::getName());
+}
+
+/**
+ * @brief Creates the threads executing the commands: WORKERS by default, or the IRC_WORKERS
+ * environment variable. With 0, commands are executed by the Reactors.
+ */
+void	Server::setExecutor()
+{
+	char const	*workers = getenv("IRC_WORKERS");
+	int			nbOfWorkers = workers ? std::atoi(workers) : WORKERS;
+
+	if (nbOfWorkers < 0 || nbOfWorkers > WORKERS_MAX)
+		throw std::invalid_argument("invalid number of executor threads: " + to_string(nbOfWorkers));
+	if (nbOfWorkers > 0)
+		_executor = new Executor(this, nbOfWorkers);
+	MSG_DEV(MSG_DEV_SVR_WORKERS, nbOfWorkers);
+}
+
+/**
+ * @brief Handles the events of the FDs that don't belong to a client
+ * (watched by the first Reactor only)
+ *
+ * @param fd FD with events, ignored if unknown (client disconnected during the loop turn)
+ */
+void	Server::handleServerEvent(int fd)
+{
+	if (fd == _serverSocket)
+		handleNewConnection();
+	else if (fd == _signalFd)
+		handleSignal();
+	else if (_resolver && fd == _resolver->getNotifyFd())
+		handleResolvedHosts();
+	else if (_bus && fd == _bus->getFd())
+		handleBus();
+}
+
+/**
+ * @brief Reads the pending signal and asks the main loop to stop
  */
-void	Server::handlePollEvents()
+void	Server::handleSignal()
 {
-	// launch poll()
-	if (poll(_fds.data(), _fds.size(), TIMEOUT) == ERROR && stopSignalReceived == false)
-		throw std::runtime_error("poll error: " + std::string(strerror(errno)));
+	signalfd_siginfo	info;
 
-	// Search in each pollfd if events happened
-	for (size_t i = 0; i < _fds.size(); i++)
+	if (read(_signalFd, &info, sizeof(info)) != sizeof(info))
+		return ;
+	msg_log(MSG_SVR_EXIT_SIG);
+	shutdown();
+}
+
+/**
+ * @brief Handle the connections waiting on the server socket
+ * 
+ * @note Accepts until EAGAIN, with a maximum of ACCEPT_BUDGET clients per loop turn.
+ * Sockets are created non blocking (and not inherited by child processes).
+ */
+void	Server::handleNewConnection()
+{
+	for (int i = 0; i < ACCEPT_BUDGET; i++)
 	{
-		//event detected
-		if (_fds[i].revents & POLLIN)
+		// 1) Creation of the client address/socket
+		sockaddr_in		clientAddr = {};
+		int	clientSocket = _reactors[0]->accept(_serverSocket, clientAddr);
+		if (clientSocket == ERROR)
 		{
-			if (_fds[i].fd == _serverSocket)
-				handleNewConnection();
-			else
-				handleIncomingData(_fds[i].fd);
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				return ;
+			if (errno == EMFILE || errno == ENFILE)
+			{
+				if (!rejectConnection())
+					return ;
+			}
+			else if (errno != EINTR && errno != ECONNABORTED)
+			{
+				MSG_ERR(strerror(errno));
+				return ;
+			}
+			continue ;
 		}
+
+		// 2) Creation of the User
+		addClient(clientSocket, clientAddr);
 	}
 }
 
 /**
- * @brief Handle the connection from a new client
+ * @brief Registers a newly accepted client
  * 
- * @param socket_fd the FD where poll
+ * @param clientSocket socket returned by Reactor::accept()
+ * @param clientAddr address of the client
  */
-void	Server::handleNewConnection()
+void	Server::addClient(int clientSocket, sockaddr_in const &clientAddr)
 {
-	// 1) Creation of the client address/socket
-	sockaddr_in		clientAddr = {};
-	socklen_t		clientAddr_len = sizeof(clientAddr);
-	int	clientSocket = accept(_serverSocket, (struct sockaddr*)&clientAddr, &clientAddr_len);
-	if (clientSocket == ERROR)
+	ServerLock	lock(_lock);
+
+	// 1 - create the User and add it to the list
+	//     if the hostname isn't in cache, the numeric address is used until it is resolved
+	std::string	hostname;
+	bool		isCached = _resolver->lookup(clientAddr.sin_addr, hostname);
+	User		*newUser = new User(this, clientSocket, isCached ? hostname : inet_ntoa(clientAddr.sin_addr));
+	Reactor		*reactor = _reactors[_nextReactor++ % _reactors.size()];
+	newUser->setReactor(reactor);
+	_users[clientSocket] = newUser;
+	_nbOfClients++;
+
+	// 2 - hostname resolution, out of the event loop
+	if (!isCached)
 	{
-		MSG_ERR(strerror(errno));
-		return ;
+		newUser->setHostPending(true);
+		_resolver->resolve(clientSocket, clientAddr.sin_addr);
 	}
 
-	// 2 Store the client's hostname
-	char	clientHostname[NI_MAXHOST];
+	// 3 - console message
+	msg_log(MSG_CLT_CONNECTED, clientSocket);
 
-	int		res = getnameinfo((struct sockaddr *) &clientAddr, sizeof(clientAddr), clientHostname, NI_MAXHOST, NULL, 0, NI_NUMERICSERV);
-	if (res != 0)
+	// 4 - Change client's status to CONNECTED
+	newUser->setStatus(CONNECTED);
+
+	// 5 - the Reactor starts watching the socket
+	reactor->adopt(newUser);
+}
+
+/**
+ * @brief Gives their hostname to the clients whose resolution ended
+ * @note Results for a closed connection (or a FD reused since) are ignored.
+ */
+void	Server::handleResolvedHosts()
+{
+	std::vector<s_dnsResult>	results;
+	ServerLock					lock(_lock);
+
+	_resolver->collect(results);
+	for (std::vector<s_dnsResult>::iterator it = results.begin(); it != results.end(); it++)
 	{
-		close(clientSocket);
-		MSG_ERR(strerror(errno));
-		return ;
+		User	*user = getUserwithFd(it->fd);
+
+		if (user && user->isHostPending() && user->getHostname() == it->ip)
+		{
+			user->setResolvedHostname(it->hostname);
+
+			// lines received while registration was waiting can be executed
+			resumeClient(user);
+		}
 	}
+}
 
-	// 3 - add to poll list
-	addToPoll(clientSocket, false);
+/**
+ * @brief The client doesn't wait anymore (see User::isWaiting()), its lines can be executed
+ */
+void	Server::resumeClient(User *user)
+{
+	user->getReactor()->resumeInput(user->getSocketFd());
+	if (_executor)
+		_executor->resume(user);
+}
 
-	// 4 - create the User and add it to the list
-	User	*newUser = new User(this, clientSocket, clientHostname);
-	_users[clientSocket] = newUser;
+/**
+ * @brief The Supervisor sent messages: they are given to the local clients
+ */
+void	Server::handleBus()
+{
+	ServerLock	lock(_lock);
 
-	// 5 - console message
-	msg_log(MSG_CLT_CONNECTED(clientSocket));
+	deliverBusMessages();
+}
 
-	// 6 - Change client's status to CONNECTED
-	newUser->setStatus(CONNECTED);
+/**
+ * @brief Applies the messages of the other workers (lock held)
+ * @note USER lines go to the client with the nickname, FWD commands are executed for
+ * the channels of this worker, RENAME and DROP follow the clients of the other workers
+ * in these channels, answers to claims end the NICK waiting for them. CHAN keeps the
+ * channels of the other workers a client of this one is in, LOST removes it from the ones
+ * of a worker that exited. The worker stops if the Supervisor is gone.
+ */
+void	Server::deliverBusMessages()
+{
+	std::vector<s_busMsg>	messages;
+	bool					isAlive = _bus->collect(messages);
+
+	for (std::vector<s_busMsg>::iterator it = messages.begin(); it != messages.end(); it++)
+	{
+		User	*user = getUserWithNickname(it->target);
+
+		if (it->type == "CLAIMED" || it->type == "TAKEN")
+			endClaim(it->target, it->type == "CLAIMED");
+		else if (it->type == "FWD")
+			executeForwarded(it->line, it->target == "*");
+		else if (it->type == "USER" && user && !user->isRemote())
+			user->sendToClient(it->line);
+		else if (it->type == "RENAME" && user && user->isRemote())
+			user->setNickname(it->line);
+		else if (it->type == "DROP" && user && user->isRemote())
+			deleteRemoteUser(user, it->line);
+		else if (it->type == "CHAN" && user && !user->isRemote() && !it->line.empty())
+			user->setRemoteChannel(it->line.substr(1), it->line[0] == '+');
+		else if (it->type == "LOST")
+			leaveLostChannels(std::atoi(it->target.c_str()));
+	}
+	if (!isAlive)
+	{
+		msg_log(MSG_SVR_BUS_LOST);
+		shutdown();
+	}
 }
 
 /**
- * @brief Handle when POLLIN detected in a client
- * 
- * @param clientfd client's socket FD
- */
-void	Server::handleIncomingData(int &clientfd)
-{
-	int					bytesReceived;
-	char				buffer[BUFFER_SIZE];
-	std::vector<s_msg>	fullMsg;
-	User	*user = _users.find(clientfd)->second;
-	static std::string	incompleteLine;
-	
-	memset(buffer, 0, sizeof(buffer));
-	bytesReceived = recv(clientfd, buffer, sizeof(buffer) -1, 0);
-	if (bytesReceived == ERROR || bytesReceived == 0 || bytesReceived >= 512)
+ * @brief No FD left for a new client: the spare FD is released to accept
+ * and close the connection, then taken back.
+ * @return false if there was no connection to reject
+ * @note Without that, the connection stays in the backlog and the server socket
+ * is reported ready at every loop turn.
+ */
+bool	Server::rejectConnection()
+{
+	if (_spareFd == ERROR)
+		return (false);
+	close(_spareFd);
+	int	clientSocket = accept(_serverSocket, NULL, NULL);
+	if (clientSocket != ERROR)
 	{
-		disconnectClient(user);
-		return ;
+		close(clientSocket);
+		MSG_ERR(MSG_SVR_NO_FD_LEFT);
 	}
-	else
+	_spareFd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+	return (clientSocket != ERROR);
+}
+
+/**
+ * @brief Executes the complete lines of the client's buffer
+ *
+ * @param user client whose lines are executed
+ * @param linesBudget max number of lines to execute, decreased for each line
+ * @return false if the client has been disconnected
+ * @note Called by the client's Reactor with the lock held (without Executor).
+ * @note RFC2812:2.3 limit (512 char with the line ending) is checked for each line.
+ */
+bool	Server::executeLines(User *user, int &linesBudget)
+{
+	LineBuffer	&input = user->getInput();
+	char const	*line;
+	size_t		len;
+
+	// lines after registration (or a NICK claimed to the Supervisor) wait until it ends, or until the penalty goes down
+	while (linesBudget > 0 && !user->isWaiting() && canExecute(user) && input.nextLine(line, len))
 	{
-		buffer[bytesReceived] = '\0';
-		incompleteLine += buffer;
+		linesBudget--;
+		if (len > MSG_MAX_LEN - 2)
+		{
+			disconnectClient(user);
+			return (false);
+		}
+		if (len == 0)
+			continue ;
+		s_msg	msg = parseLine(line, len);
+		chargeCommand(user, msg);
+		if (!executeCommand(user, msg))
+			return (false);
+	}
+	user->getFlood().throttled = input.hasLine() && !canExecute(user);
 
-		if (!incompleteLine.empty() && incompleteLine[incompleteLine.size() - 1] == '\n')
+	// no line ending in sight
+	if (input.size() >= MSG_MAX_LEN && !input.hasLine())
+	{
+		disconnectClient(user);
+		return (false);
+	}
+	return (true);
+}
+
+/**
+ * @brief Executes one command of a client (lock held)
+ *
+ * @return false if the client has been disconnected (QUIT)
+ */
+bool	Server::executeCommand(User *user, s_msg &msg)
+{
+	int	clientfd = user->getSocketFd();
+
+	execute(this, user, msg);
+
+	// client left (QUIT)
+	return (getUserwithFd(clientfd) == user);
+}
+
+/**
+ * @brief Frames and parses the complete lines of the client's buffer, for the Executor
+ *
+ * @param user client whose lines are framed
+ * @param linesBudget max number of lines to frame, decreased for each line
+ * @param commands filled with the parsed lines: the buffer is reused before they are
+ * executed, so the lines are copied one after the other in the client's arena block
+ * (a new one is started when it is full)
+ * @return false if the client must be disconnected (RFC2812:2.3 limit exceeded)
+ * @note Called by the client's Reactor without the lock: only the client's buffers
+ * and flood control state are used.
+ */
+bool	Server::parseLines(User *user, int &linesBudget, std::vector<s_command> &commands)
+{
+	LineBuffer		&input = user->getInput();
+	SharedBuffer	&arena = user->getCommandQueue().arena;
+	char const		*line;
+	size_t			len;
+
+	while (linesBudget > 0 && canExecute(user) && input.nextLine(line, len))
+	{
+		linesBudget--;
+		if (len > MSG_MAX_LEN - 2)
+			return (false);
+		if (len > 0)
 		{
-			// PARSE INCOMMING DATA AND LAUNCH COMMANDS
-			parseIncomingData(incompleteLine, fullMsg);
-			for (msg_iterator it = fullMsg.begin(); it != fullMsg.end(); it++)
-			{
-				//display_s_msg(*it);
-				execute(this, user, *it);
-			}
-			incompleteLine.clear();
+			s_command	command;
+
+			if (!arena.hasRoom(len))
+				arena = SharedBuffer(COMMANDS_BLOCK);
+			command.block = arena;
+			command.msg = parseLine(arena.append(line, len), len);
+			command.isShared = isSharedCommand(command.msg.cmdId);
+			chargeCommand(user, command.msg);
+			commands.push_back(command);
 		}
 	}
+	user->getFlood().throttled = input.hasLine() && !canExecute(user);
+
+	// no line ending in sight
+	return (input.size() < MSG_MAX_LEN || input.hasLine());
 }
 
 /**
- * @brief Parsing of incoming data : separate all lines
- * 
- * @param buffer 	raw buffer
- * @param fullMsg 	vector to fill with each line
+ * @brief Flood control: whether the client's penalty lets it execute another line
+ * @note RFC1459:8.10, the penalty can't be more than FLOOD_BURST ms ahead of the clock.
+ * Called by the client's Reactor, the clock is the one of its loop turn.
  */
-void	Server::parseIncomingData(std::string const &buffer, std::vector<s_msg> &fullMsg)
+bool	Server::canExecute(User *user)
 {
-	std::istringstream	iss(buffer);
-	std::string			line;
+	s_flood			&flood = user->getFlood();
+	unsigned long	now = user->getReactor()->getClock();
+
+	if (flood.exempt)
+		return (true);
+	flood.penaltyUntil = std::max(flood.penaltyUntil, now);
+	return (flood.penaltyUntil <= now + FLOOD_BURST);
+}
 
-	while (std::getline(iss, line))
+/**
+ * @brief Cost of a command (ms), a message to a channel costs more than one to a nickname
+ * and PING/PONG cost less than the others
+ */
+static unsigned long	commandCost(s_msg const &msg)
+{
+	if (msg.cmdId == CMD_PING || msg.cmdId == CMD_PONG)
+		return (FLOOD_COST_LIGHT);
+	if (msg.cmdId != CMD_PRIVMSG || msg.args.empty())
+		return (FLOOD_COST);
+
+	Slice const		&targets = msg.args[0];
+	unsigned long	cost = 0;
+	bool			isTargetStart = true;
+
+	for (size_t i = 0; i < targets.size(); i++)
 	{
-		if (!line.empty())
+		if (targets[i] == ',')
+			isTargetStart = true;
+		else if (isTargetStart)
 		{
-			s_msg	parsedLine = parseLine(line);
-			fullMsg.push_back(parsedLine);
+			cost += (targets[i] == '#' || targets[i] == '&') ? FLOOD_COST_CHANNEL : FLOOD_COST;
+			isTargetStart = false;
 		}
 	}
+	return (std::max(cost, static_cast<unsigned long>(FLOOD_COST)));
+}
+
+/**
+ * @brief Adds the cost of a command to the client's penalty (see canExecute())
+ */
+void	Server::chargeCommand(User *user, s_msg const &msg)
+{
+	s_flood	&flood = user->getFlood();
+
+	if (!flood.exempt)
+		flood.penaltyUntil += commandCost(msg);
+}
+
+/**
+ * @brief Moves to the next word of a line
+ *
+ * @return false if there is no word left
+ */
+static bool	skipSpaces(char const *&it, char const *end)
+{
+	while (it != end && isspace(static_cast<unsigned char>(*it)))
+		it++;
+	return (it != end);
 }
 
 /**
- * @brief Parsing of incoming data : parse one line into an s_msg
+ * @brief Finds the next word of a line, words are separated by whitespaces
+ * @note A plain loop: words are too short for the Scanner's vector compares to pay off.
+ *
+ * @param it current position, moved after the word
+ * @param end end of the line
+ * @param word set to the first char of the word
+ * @param wordLen set to the length of the word
+ * @return false if there is no word left
+ */
+static bool	nextWord(char const *&it, char const *end, char const *&word, size_t &wordLen)
+{
+	if (!skipSpaces(it, end))
+		return (false);
+	word = it;
+	while (it != end && !isspace(static_cast<unsigned char>(*it)))
+		it++;
+	wordLen = it - word;
+	return (true);
+}
+
+/**
+ * @brief Parsing of incoming data : parse one line into an s_msg, in a single pass
  * 
- * @param line the line to analyse
- * @return s_msg filled
+ * @param line the line to analyse, inside the client's buffer
+ * @param len length of the line, without the line ending
+ * @return s_msg filled with views into the line (nothing is copied nor allocated),
+ * and the id of the command
+ * @note The trailing is kept as received (spaces included). After 14 middle params,
+ * the rest of the line is the trailing (RFC2812:2.3.1).
  */
-s_msg	Server::parseLine(std::string const &line)
+s_msg	Server::parseLine(char const *line, size_t len)
 {
-	s_msg				parsedMsg;
-	std::istringstream	iss(line);
+	s_msg		parsedMsg;
+	char const	*it = line;
+	char const	*end = line + len;
+	char const	*word;
+	size_t		wordLen;
 
-	// 0 - init s_msg to zero
-	parsedMsg.prefix = "";
-	parsedMsg.cmd = "";
-	parsedMsg.args.clear();
-	parsedMsg.trailing = "";
+	// 0 - init s_msg
 	parsedMsg.trailing_sign	= false;
+	parsedMsg.cmdId = CMD_UNKNOWN;
 
 	// 1 - extract prefix if exists
-	if (line[0] == ':')
+	if (it != end && *it == ':')
 	{
-		size_t	prefixEnd = line.find(' ');
-		if (prefixEnd != std::string::npos)
+		char const	*prefixEnd = std::find(it, end, ' ');
+		if (prefixEnd != end)
 		{
-				parsedMsg.prefix = line.substr(1, prefixEnd - 1);
-				iss.ignore(prefixEnd + 1);
+			parsedMsg.prefix = Slice(it + 1, prefixEnd - it - 1);
+			it = prefixEnd + 1;
 		}
 		else //Incorrect format msg
 			return (parsedMsg);
 	}
 
 	// 2 - extract command
-	iss >> parsedMsg.cmd;
+	if (nextWord(it, end, word, wordLen))
+	{
+		parsedMsg.cmd = Slice(word, wordLen);
+		parsedMsg.cmdId = commandId(word, wordLen);
+	}
 
 	// 3 - extract arguments
-	std::string	arg;
-	while (iss >> arg)
+	while (skipSpaces(it, end))
 	{
-		if (arg[0] == ':')  //trailing
+		if (*it == ':' || parsedMsg.args.full())  //trailing: the rest of the line, not scanned
 		{
+			if (*it == ':')
+				it++;
 			parsedMsg.trailing_sign = true;
-			if (!parsedMsg.trailing.empty())
-				parsedMsg.trailing += ' ' + arg.substr(1);
-			else
-				parsedMsg.trailing = arg.substr(1);
-			
-			// Concaténer tous les mots restants
-			while (iss >> arg)
-			{
-				parsedMsg.trailing += ' ' + arg;
-			}
+			parsedMsg.trailing = Slice(it, end - it);
 			break ;
 		}
-		else
-			parsedMsg.args.push_back(arg);
+		nextWord(it, end, word, wordLen);
+		parsedMsg.args.push_back(Slice(word, wordLen));
 	}
 	return (parsedMsg);
 }
@@ -329,29 +711,66 @@ s_msg	Server::parseLine(std::string const &line)
 /**
  * @brief Run the IRC server
  * 
+ * @note - 0) Multi-process mode: the Supervisor forks the workers, each one goes on from here
  * @note - 1) Creation and configuration of the server's network socket
- * @note - 2) Adding server's socket to POLLFD (list of sockets that poll() have to check)
- * @note - 3) Server is now running and wait for activities from clients. To leave, use the EXIT signal (CTRL + C).
+ * @note - 2) Creation of the event loops, server's socket and SIGINT are watched by the first one
+ * @note - 3) Creation of the threads resolving clients' hostnames and of the other event loops threads
+ * @note - 4) Server is now running and wait for activities from clients. To leave, use the EXIT signal (CTRL + C).
  */
 void	Server::start()
 {
 	msg_log(MSG_SVR_START);
-	signal(SIGINT, handleSignal);
 	signal(SIGPIPE, SIG_IGN);
 
+	// 0 - worker processes (the Supervisor leaves once they are stopped)
+	if (!setBus())
+		return ;
+
 	// 1 - setup of the server socket
 	setServerSocket();
 
-	// 2 - add server's socket to the list of pollfd
-	addToPoll(_serverSocket, true);
-
-	// 3 - main loop, waiting for activity on sockets with poll (or for exit signal)
+	// 2 - creation of the event loops, server's socket and signals are watched
+	setReactors();
+	_reactors[0]->watchListener(_serverSocket);
+	setSignalFd();
+
+	// 3 - threads (created once signals are blocked)
+	_resolver = new Resolver(DNS_THREADS);
+	addToPoll(_resolver->getNotifyFd());
+	if (_bus)
+		addToPoll(_bus->getFd());
+	setExecutor();
+	for (size_t i = 1; i < _reactors.size(); i++)
+		_reactors[i]->spawn();
+
+	// 4 - main loop, waiting for activity on sockets (or for exit signal)
 	msg_log(MSG_SVR_STARTED);
-	while (stopSignalReceived == false)
-		handlePollEvents();
+	_reactors[0]->run();
+	shutdown();
+	if (_executor)
+		_executor->stop();
+	for (size_t i = 0; i < _reactors.size(); i++)
+		_reactors[i]->join();
 }
 
-void	Server::shutdown() { stopSignalReceived = true; }
+/**
+ * @brief Stops all the event loops (from any thread)
+ */
+void	Server::shutdown()
+{
+	for (std::vector<Reactor *>::iterator it = _reactors.begin(); it != _reactors.end(); it++)
+		(*it)->stop();
+}
+
+/**
+ * @brief POWEROFF: stops the server, and the other worker processes in multi-process mode
+ */
+void	Server::powerOff()
+{
+	if (_bus)
+		_bus->requestShutdown();
+	shutdown();
+}
 
 /* #endregion */
 
@@ -366,11 +785,31 @@ void	Server::disconnectClient(User *client)
 {
 	int	clientFD = client->getSocketFd();
 
-	// 1) remove client from all Channels
-	client->leaveAllChannels("QUIT");
+	// 0) command executed by the Executor: the client's Reactor will disconnect it at the end of its loop turn
+	if (!client->getReactor()->isOwnThread())
+	{
+		client->setQuitting();
+		client->getReactor()->evict(clientFD);
+		return ;
+	}
+
+	// 1) remove client from all Channels, its nickname is free for the other workers,
+	//    which remove it from theirs (the one it claimed is released once the Supervisor
+	//    answers, see endClaim())
+	std::string	why = client->getLeavingMessage();
 
-	// 2) remove client form pollfd list
-	deleteFromPoll(clientFD);
+	client->leaveAllChannels("QUIT");
+	if (_bus && client->getNickname() != "*")
+		_bus->release(client->getNickname(), why);
+	if (client->isWaiting())
+		forgetClaims(client);
+
+	// 2) send what is still queued if possible, then the client's Reactor forgets it
+	client->flush();
+	client->getReactor()->release(clientFD);
+	if (_executor)
+		_executor->forget(client);
+	_nbOfClients--;
 
 	// 3) remove client from Users list
 	deleteUser(clientFD);
@@ -379,9 +818,21 @@ void	Server::disconnectClient(User *client)
 	close(clientFD);
 
 	// 5) delete
+	msg_log(MSG_CLT_SENDQ(clientFD, client->getSendQPeak()));
 	delete client;
 
-	msg_log(MSG_CLT_DISCONNECTED(clientFD));
+	msg_log(MSG_CLT_DISCONNECTED, clientFD);
+}
+
+/**
+ * @brief Asks for the disconnection of a client whose SendQ limit is exceeded
+ * 
+ * @param client client to disconnect at the end of the loop turn (see handleEvictions())
+ */
+void	Server::evictClient(User *client)
+{
+	msg_log(MSG_CLT_SENDQ_EXCEEDED, client->getSocketFd(), client->getNickname());
+	client->getReactor()->evict(client->getSocketFd());
 }
 
 /**
@@ -412,7 +863,7 @@ void	Server::newChannel(std::string const &name, User *user)
 {
 	Channel	*chan = new Channel(this, name, user);
 
-	_channels.push_back(chan);
+	_channels.insert(name, chan);
 }
 
 /**
@@ -422,7 +873,7 @@ void	Server::newChannel(std::string const &name, User *user, std::string const &
 {
 	Channel	*chan = new Channel(this, name, user, key);
 
-	_channels.push_back(chan);
+	_channels.insert(name, chan);
 }
 
 /**
@@ -430,74 +881,326 @@ void	Server::newChannel(std::string const &name, User *user, std::string const &
  */
 void	Server::deleteChannel(Channel *channel)
 {
-	for (channel_iterator it = _channels.begin(); it != _channels.end();)
-	{
-		if (*it == channel)
-		{
-			delete *it;
-			it = _channels.erase(it);
-			break ;
-		}
-		else
-			it++;
-	}
+	if (findChannel(channel->getChannelName()) == channel)
+		_channels.erase(channel->getChannelName());
+	delete channel;
 }
 
 /**
- * @brief Searchs and returns a Channel * from his name
+ * @brief Searchs and returns a Channel * from his name, in any case ("#Chan" is "#chan")
  */
 Channel	*Server::findChannel(std::string const &name)
 {
-	if (name.empty())
+	Channel	**channel = _channels.find(name);
+
+	if (channel == NULL)
 		return (NULL);
-	for (channel_iterator it = _channels.begin(); it != _channels.end(); it++)
+	return (*channel);
+}
+
+/* #endregion */
+
+/* #region Worker processes */
+
+/**
+ * @brief Multi-process mode: asks the Supervisor if a nickname is free among the other workers
+ *
+ * @return false if a client of another worker is known to have it. Otherwise the client
+ * waits for the answer (see User::isWaiting()) and its NICK ends in endClaim():
+ * nothing blocks meanwhile, the Server's lock is released.
+ * @note Without worker processes, or for clients that didn't give the password yet
+ * (their NICK is refused anyway), there is nothing to ask: true, and the client doesn't wait.
+ */
+bool	Server::claimNickname(User *user, std::string const &nickname)
+{
+	if (!_bus || user->getStatus() < PASSWORDACCEPTED)
+		return (true);
+	if (!_bus->claim(nickname, user->getNickname()))
+		return (false);
+	_claims.insert(nickname, user);
+	user->setNickPending(true);
+	return (true);
+}
+
+/**
+ * @brief The Supervisor answered a claim (lock held): the client's NICK ends,
+ * its next lines can be executed
+ *
+ * @param nickname nickname as claimed
+ * @param isFree whether no other worker has it
+ * @note The nickname is released if the client left meanwhile.
+ */
+void	Server::endClaim(std::string const &nickname, bool isFree)
+{
+	User	**claimant = _claims.find(nickname);
+
+	if (claimant == NULL)
 	{
-		if ((*it)->getChannelName() == name)
-			return (*it);
+		if (isFree)
+			_bus->release(nickname, "*");
+		return ;
 	}
-	return (NULL);
+
+	User	*user = *claimant;
+
+	_claims.erase(nickname);
+	user->setNickPending(false);
+	static_cast<Nick *>(_commands[CMD_NICK])->answer(user, nickname, isFree);
+	resumeClient(user);
 }
 
-/* #endregion */
+/**
+ * @brief Client waiting for a claim, NULL if nobody of this worker claimed the nickname
+ */
+User	*Server::getClaimant(std::string const &nickname)
+{
+	User	**claimant = _claims.find(nickname);
 
-/* #region TOOLS */
+	if (claimant == NULL)
+		return (NULL);
+	return (*claimant);
+}
 
 /**
- * @brief Add a new pollfd to the list
- * 
- * @param fd the fd to enter in parameter of the new pollfd
- * @param isServer true if the pollfd concerns the server, false if not
+ * @brief Keeps the nickname index up to date, called before the client's nickname changes
+ *
+ * @param user client taking the nickname (checked as free, or its own in another case)
+ * @param nickname new nickname
+ */
+void	Server::indexNickname(User *user, std::string const &nickname)
+{
+	if (getUserWithNickname(user->getNickname()) == user)
+		_nicknames.erase(user->getNickname());
+	_nicknames.insert(nickname, user);
+}
+
+/**
+ * @brief Sends a line to a client of another worker
+ *
+ * @return false if no worker has a client with this nickname
+ */
+bool	Server::sendToRemoteUser(std::string const &nickname, std::string const &line)
+{
+	return (_bus && _bus->sendToUser(nickname, line));
+}
+
+/**
+ * @brief Nickname of a client of another worker, as chosen by the client (see Bus::getRemoteNickname())
+ *
+ * @return NULL if no other worker has a client with this nickname
+ */
+std::string const	*Server::getRemoteNickname(std::string const &nickname) const
+{
+	if (_bus == NULL)
+		return (NULL);
+	return (_bus->getRemoteNickname(nickname));
+}
+
+/**
+ * @brief Executes a command forwarded by another worker (see forward()), on behalf of its
+ * client: the client is added here, as a remote user, the first time
+ *
+ * @param line "nick user host command"
+ * @param isBroadcast sent to all the workers (JOIN 0): only for the clients already here
+ * @note A nickname that isn't owned by another worker anymore (the client left) is ignored.
+ */
+void	Server::executeForwarded(std::string const &line, bool isBroadcast)
+{
+	char const	*it = line.data();
+	char const	*end = it + line.size();
+	Slice		author[3];		// nickname, username, hostname
+
+	for (int i = 0; i < 3; i++)
+	{
+		char const	*wordEnd = std::find(it, end, ' ');
+
+		author[i] = Slice(it, wordEnd - it);
+		it = std::min(wordEnd + 1, end);
+	}
+	while (it != end && *it == ' ')
+		it++;
+
+	std::string	nickname = author[0];	// 9 characters at most: kept inline, not allocated
+	User		*user = getUserWithNickname(nickname);
+
+	if (user == NULL && !isBroadcast && _bus->isRemote(nickname))
+		user = newRemoteUser(nickname, author[1], author[2]);
+	if (user == NULL || !user->isRemote() || it == end)
+		return ;
+	if (user->getUsername() != author[1])
+		user->setUsername(author[1]);
+	if (user->getHostname() != author[2])
+		user->setHostname(author[2]);
+
+	// the command is parsed in place, in the Bus message
+	s_msg	msg = parseLine(it, end - it);
+
+	execute(this, user, msg);
+}
+
+/**
+ * @brief Client of another worker, in the channels of this one: its messages go through
+ * the Supervisor (see User::isRemote()), it is deleted once it leaves (DROP)
  */
-void	Server::addToPoll(int fd, bool isServer)
+User	*Server::newRemoteUser(std::string const &nickname, std::string const &username, std::string const &hostname)
 {
-	pollfd	newPoll;
+	User	*user = new User(this, ERROR, hostname);
 
-	newPoll.fd = fd;
-	newPoll.events = POLLIN;
-	newPoll.revents = 0;
-	_fds.push_back(newPoll);
-	if (!isServer)
-		_nbOfClients++;
+	user->setRemote();
+	user->setNickname(nickname);
+	user->setUsername(username);
+	user->setStatus(REGISTERED);
+	return (user);
 }
 
 /**
- * @brief Delete an entry from the pollfd list
+ * @brief A client of another worker left: it quits the channels of this one
  *
- * @param fd FD parameter of the pollfd to delete
+ * @param why its leaving message, "*" if none
+ * @note Unindexed first: its worker isn't told about the channels it leaves (see trackRemoteMember()).
  */
-void	Server::deleteFromPoll(int fd)
+void	Server::deleteRemoteUser(User *user, std::string const &why)
 {
-	for (pollfd_iterator it = _fds.begin(); it != _fds.end(); ++it)
+	user->setLeavingMessage(why);
+	_nicknames.erase(user->getNickname());
+	user->leaveAllChannels("QUIT");
+	delete user;
+}
+
+/**
+ * @brief A worker exited (LOST): its channels are gone, the clients of this worker that
+ * were in them are kicked by the server
+ * @note The clients of the exited worker leave the channels of this one with their DROP.
+ */
+void	Server::leaveLostChannels(int worker)
+{
+	for (std::map<int, User *>::iterator it = _users.begin(); it != _users.end(); it++)
 	{
-		if (it->fd == fd)
+		User							*user = it->second;
+		std::set<std::string>			&channels = user->getRemoteChannels();
+		std::set<std::string>::iterator	channel = channels.begin();
+
+		while (channel != channels.end())
 		{
-			_fds.erase(it);
-			_nbOfClients--;
-			break ;
+			if (_bus->getOwner(*channel) != worker)
+			{
+				channel++;
+				continue ;
+			}
+			user->sendToClient(SEND_KICK_MSG(SVR_NAME, *channel, user->getNickname(), MSG_CLT_CHANNEL_LOST));
+			channels.erase(channel++);
+		}
+	}
+}
+
+/**
+ * @brief Deletes the clients of the other workers, without telling the channels (shutdown)
+ */
+void	Server::deleteRemoteUsers()
+{
+	for (HashMap<std::string, User *, s_casefoldTraits>::iterator it = _nicknames.begin(); it != _nicknames.end(); it++)
+	{
+		User	*user = it.value();
+
+		if (user->isRemote())
+		{
+			_nicknames.erase(user->getNickname());
+			delete user;
 		}
 	}
 }
 
+/**
+ * @brief "nick user host" of a client, for the worker executing its commands
+ */
+static std::string	author(User *user)
+{
+	return (user->getNickname() + " " + user->getUsername() + " " + user->getHostname());
+}
+
+/**
+ * @brief Whether a command of the client about the channel is executed by another worker,
+ * the one owning the channel (see Bus::getOwner())
+ * @note The commands of the clients of the other workers are never forwarded again.
+ */
+bool	Server::mustForward(User *user, std::string const &channel) const
+{
+	return (_bus && !user->isRemote() && !_bus->isLocal(channel));
+}
+
+/**
+ * @brief Gives a command about a channel to the worker owning it (see mustForward())
+ *
+ * @param user client of this worker sending the command
+ * @param channel name of the channel
+ * @param command line executed by the owner, for this channel only
+ */
+void	Server::forward(User *user, std::string const &channel, std::string const &command)
+{
+	_bus->forward(_bus->getOwner(channel), author(user), command);
+}
+
+/**
+ * @brief Gives a command to all the other workers, for the channels of theirs the client is in (JOIN 0)
+ */
+void	Server::forwardToAll(User *user, std::string const &command)
+{
+	if (_bus && !user->isRemote())
+		_bus->forward(ERROR, author(user), command);
+}
+
+/**
+ * @brief Client with the nickname, here or in another worker: the latter is
+ * added here (see executeForwarded()), so that it can be invited to a channel of this worker
+ *
+ * @return NULL if no worker has a client with this nickname
+ * @note Only called once the invitation is certain to be kept (see Invite::execute()):
+ * the added User stays until its client leaves (DROP).
+ */
+User	*Server::findUser(std::string const &nickname)
+{
+	User				*user = getUserWithNickname(nickname);
+	std::string const	*remoteNickname = getRemoteNickname(nickname);
+
+	if (user == NULL && remoteNickname != NULL)
+		user = newRemoteUser(*remoteNickname, "*", "*");
+	return (user);
+}
+
+/**
+ * @brief A client of another worker joined or left a channel of this one: its worker
+ * keeps it, to kick the client from the channel if this worker exits (see leaveLostChannels())
+ * @note Not sent for a client that is gone (DROP): its nickname may already be someone else's.
+ */
+void	Server::trackRemoteMember(User *user, std::string const &channel, bool isJoined)
+{
+	if (_bus && getUserWithNickname(user->getNickname()) == user)
+		_bus->sendMembership(user->getNickname(), channel, isJoined);
+}
+
+/* #endregion */
+
+/* #region TOOLS */
+
+/**
+ * @brief Starts watching a server's FD (events handled by handleServerEvent())
+ * 
+ * @param fd the fd to watch
+ */
+void	Server::addToPoll(int fd) { _reactors[0]->watch(fd); }
+
+/**
+ * @brief The client leaves before the Supervisor answered its claim
+ */
+void	Server::forgetClaims(User *user)
+{
+	for (HashMap<std::string, User *, s_casefoldTraits>::iterator it = _claims.begin(); it != _claims.end(); it++)
+	{
+		if (it.value() == user)
+			_claims.erase(std::string(it.key()));
+	}
+}
+
 /**
  * @brief Remove an User fron the Users list
  * 
@@ -508,7 +1211,11 @@ void	Server::deleteUser(int fd)
 	client_iterator it = _users.find(fd);
 
 	if (it != _users.end())
+	{
+		if (getUserWithNickname(it->second->getNickname()) == it->second)
+			_nicknames.erase(it->second->getNickname());
 		_users.erase(it);
+	}
 }
 /* #endregion */
 
@@ -517,22 +1224,30 @@ void	Server::deleteUser(int fd)
 /**
  * @brief Search an user with his nickname
  * 
- * @param nickname user to search
+ * @param nickname user to search, in any case ("Bob" is "bob", "[a]" is "{a}")
  * @return NULL if not found or a pointer to the User if found
  */
 User	*Server::getUserWithNickname(std::string const &nickname)
 {
-	for (client_iterator it = _users.begin(); it != _users.end(); it++)
-	{
-		if (!nickname.compare(it->second->getNickname()))
-			return (it->second);
-	}
-	return (NULL);
+	User	**user = _nicknames.find(nickname);
+
+	if (user == NULL)
+		return (NULL);
+	return (*user);
 }
 
 std::string const &Server::getPassword() const { return _password; }
 
-std::map<std::string, Command *> &Server::getCommands() { return _commands; }
+pthread_rwlock_t	&Server::getLock() { return _lock; }
+
+Executor		*Server::getExecutor() { return _executor; }
+
+Command			*Server::getCommand(e_cmdId id) const { return _commands[id]; }
+
+/**
+ * @brief All the channels (see HashMap::iterator), for commands listing them
+ */
+channel_map		&Server::getChannels() { return _channels; }
 
 
 /**
@@ -543,12 +1258,11 @@ std::map<std::string, Command *> &Server::getCommands() { return _commands; }
  */
 User	*Server::getUserwithFd(int client_socket)
 {
-	for (client_iterator it = _users.begin(); it != _users.end(); it++)
-	{
-		if (client_socket == it->first)
-			return (it->second);
-	}
-	return (NULL);
+	client_iterator	it = _users.find(client_socket);
+
+	if (it == _users.end())
+		return (NULL);
+	return (it->second);
 }
 
 /* #endregion */
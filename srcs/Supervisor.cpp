@@ -0,0 +1,433 @@
+#include "ft_irc.hpp"
+
+/* #region Constructor/Destructor */
+
+/**
+ * @brief Blocks SIGINT and SIGCHLD, they are received through a signalfd
+ *
+ * @param nbOfWorkers number of worker processes
+ */
+Supervisor::Supervisor(int nbOfWorkers): _nbOfWorkers(nbOfWorkers), _pids(nbOfWorkers, ERROR),
+	_started(nbOfWorkers, 0), _buses(nbOfWorkers, ERROR),
+	_queues(nbOfWorkers), _queuedBytes(nbOfWorkers, 0), _signalFd(ERROR), _poller(new PollPoller()), _stopping(false),
+	_workerId(ERROR)
+{
+	sigset_t	mask;
+
+	sigemptyset(&mask);
+	sigaddset(&mask, SIGINT);
+	sigaddset(&mask, SIGCHLD);
+	if (sigprocmask(SIG_BLOCK, &mask, NULL) == ERROR)
+		throw std::runtime_error("unable to block signals: " + std::string(strerror(errno)));
+	if ((_signalFd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC)) == ERROR)
+		throw std::runtime_error("unable to create signalfd: " + std::string(strerror(errno)));
+	_poller->add(_signalFd, POLLIN);
+}
+
+Supervisor::~Supervisor()
+{
+	for (int id = 0; id < _nbOfWorkers; id++)
+		closeBus(id);
+	if (_signalFd != ERROR)
+		close(_signalFd);
+	delete _poller;
+}
+/* #endregion */
+
+/* #region PUBLIC */
+
+/**
+ * @brief Forks the workers, then routes their messages until they are all stopped
+ *
+ * @return in a worker: its Bus FD, the worker goes on as a Server.
+ * In the Supervisor: ERROR, once every worker has exited.
+ */
+int	Supervisor::run()
+{
+	int	busFd;
+
+	msg_log(MSG_SUP_STARTED(_nbOfWorkers));
+	for (int id = 0; id < _nbOfWorkers; id++)
+	{
+		if ((busFd = spawn(id)) != ERROR)
+			return (busFd);
+	}
+
+	while (hasWorkers())
+	{
+		_poller->wait(TIMEOUT);
+
+		// copied: a respawn adds a FD to the Poller
+		std::vector<pollfd>	ready = _poller->getReady();
+
+		for (std::vector<pollfd>::iterator it = ready.begin(); it != ready.end(); it++)
+		{
+			if (it->fd == _signalFd)
+			{
+				if ((busFd = handleSignal()) != ERROR)
+					return (busFd);
+				continue ;
+			}
+			for (int id = 0; id < _nbOfWorkers; id++)
+			{
+				if (_buses[id] == it->fd && (it->revents & POLLOUT))
+					flushQueue(id);
+				if (_buses[id] == it->fd && (it->revents & (POLLIN | POLLERR | POLLHUP)))
+					handleBus(id);
+			}
+		}
+	}
+	msg_log(MSG_SUP_STOPPED);
+	return (ERROR);
+}
+
+int	Supervisor::getWorkerId() const { return _workerId; }
+
+/* #endregion */
+
+/* #region PRIVATE */
+
+/**
+ * @brief How a worker ended, for the logs
+ */
+static std::string	describeExit(int status)
+{
+	if (WIFSIGNALED(status))
+		return ("killed by signal " + to_string(WTERMSIG(status)) + " (" + strsignal(WTERMSIG(status)) + ")");
+	return ("exit status " + to_string(WEXITSTATUS(status)));
+}
+
+/**
+ * @brief Creates the Bus of a worker and forks it
+ *
+ * @return in the worker: its end of the Bus. In the Supervisor: ERROR.
+ * @note The new worker is told which nicknames the others already have.
+ */
+int	Supervisor::spawn(int id)
+{
+	int		sockets[2];
+	pid_t	pid;
+
+	if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sockets) == ERROR)
+		throw std::runtime_error("unable to create worker bus: " + std::string(strerror(errno)));
+	if ((pid = fork()) == ERROR)
+	{
+		close(sockets[0]);
+		close(sockets[1]);
+		throw std::runtime_error("unable to fork worker: " + std::string(strerror(errno)));
+	}
+
+	// worker: only keeps its end of the Bus, the Server blocks its own signals
+	if (pid == 0)
+	{
+		sigset_t	mask;
+
+		close(sockets[0]);
+		for (int i = 0; i < _nbOfWorkers; i++)
+			closeBus(i);
+		close(_signalFd);
+		_signalFd = ERROR;
+		_workerId = id;
+		sigemptyset(&mask);
+		sigaddset(&mask, SIGCHLD);
+		sigprocmask(SIG_UNBLOCK, &mask, NULL);
+		return (sockets[1]);
+	}
+
+	close(sockets[1]);
+	if (fcntl(sockets[0], F_SETFL, O_NONBLOCK) == ERROR)
+		MSG_ERR(strerror(errno));
+	_pids[id] = pid;
+	_started[id] = time(NULL);
+	_buses[id] = sockets[0];
+	_poller->add(sockets[0], POLLIN);
+	msg_log(MSG_SUP_WORKER_STARTED(id, pid));
+
+	for (std::map<std::string, std::string>::iterator it = _names.begin(); it != _names.end(); it++)
+		send(id, "OWN " + it->second);
+	return (ERROR);
+}
+
+/**
+ * @brief SIGINT stops the workers, SIGCHLD reaps the ones that exited
+ *
+ * @return in a restarted worker: its Bus FD (see spawn()). In the Supervisor: ERROR.
+ */
+int	Supervisor::handleSignal()
+{
+	signalfd_siginfo	info;
+	pid_t				pid;
+	int					status;
+	int					busFd;
+
+	while (read(_signalFd, &info, sizeof(info)) == sizeof(info))
+	{
+		if (info.ssi_signo == SIGINT && !_stopping)
+		{
+			msg_log(MSG_SVR_EXIT_SIG);
+			stopWorkers();
+		}
+	}
+
+	// SIGCHLD of several workers can be merged: every exited one is reaped
+	while ((pid = waitpid(-1, &status, WNOHANG)) > 0)
+	{
+		for (int id = 0; id < _nbOfWorkers; id++)
+		{
+			if (_pids[id] == pid && (busFd = handleWorkerExit(id, status)) != ERROR)
+				return (busFd);
+		}
+	}
+	return (ERROR);
+}
+
+/**
+ * @brief Frees the nicknames of an exited worker and restarts it, unless the workers
+ * are being stopped (SIGINT, or POWEROFF in a worker, see SHUTDOWN)
+ * The others are told (LOST): their clients are kicked from the channels it owned.
+ *
+ * @return in the restarted worker: its Bus FD. In the Supervisor: ERROR.
+ * @note What the worker sent before exiting is handled first (its SHUTDOWN request).
+ * @note A worker exiting less than WORKER_MIN_UPTIME seconds after its start isn't
+ * restarted (it would fail again, e.g. the port can't be bound): all of them are stopped.
+ */
+int	Supervisor::handleWorkerExit(int id, int status)
+{
+	std::map<std::string, int>::iterator	it = _nicks.begin();
+
+	handleBus(id);
+	_pids[id] = ERROR;
+	closeBus(id);
+	while (it != _nicks.end())
+	{
+		std::map<std::string, int>::iterator	current = it++;
+
+		if (current->second == id)
+		{
+			broadcast(id, "DROP " + current->first + " *");
+			_names.erase(current->first);
+			_nicks.erase(current);
+		}
+	}
+	broadcast(id, "LOST " + to_string(id));
+	if (_stopping)
+		return (ERROR);
+	if (time(NULL) - _started[id] < WORKER_MIN_UPTIME)
+	{
+		msg_log(MSG_SUP_WORKER_FAILED(id, describeExit(status)));
+		stopWorkers();
+		return (ERROR);
+	}
+	msg_log(MSG_SUP_WORKER_EXITED(id, describeExit(status)));
+	return (spawn(id));
+}
+
+/**
+ * @brief Reads the pending messages of a worker
+ * @note On EOF the Bus is closed, the worker is handled once reaped (SIGCHLD).
+ */
+void	Supervisor::handleBus(int id)
+{
+	char	buffer[BUS_MSG_MAX];
+	ssize_t	ret;
+
+	while (_buses[id] != ERROR)
+	{
+		ret = recv(_buses[id], buffer, sizeof(buffer), MSG_DONTWAIT);
+		if (ret > 0)
+			handleMessage(id, std::string(buffer, ret));
+		else if (ret == ERROR && errno == EINTR)
+			continue ;
+		else if (ret == ERROR && (errno == EAGAIN || errno == EWOULDBLOCK))
+			return ;
+		else
+			closeBus(id);
+	}
+}
+
+/**
+ * @brief Routes a message of a worker
+ *
+ * @note - CLAIM nick previous: grants the nickname if no other worker has it (answer CLAIMED/TAKEN nick),
+ * the others are told with OWN, or RENAME previous nick if the client already had one
+ * @note - RELEASE nick why: the nickname is free again (DROP nick why to the others)
+ * @note - USER nick line: given to the worker owning the nickname
+ * @note - CHAN nick +channel/-channel: given to the worker owning the nickname (its client joined or left
+ * a channel of the sender)
+ * @note - FWD worker author command: given to the worker owning the channel, to all the others if "*"
+ * @note - SHUTDOWN: POWEROFF in a worker, all of them are stopped
+ */
+void	Supervisor::handleMessage(int id, std::string const &msg)
+{
+	size_t		typeEnd = msg.find(' ');
+	size_t		targetEnd = msg.find(' ', typeEnd + 1);
+	std::string	type = msg.substr(0, typeEnd);
+	std::string	target;
+	std::string	param;
+
+	if (type == "SHUTDOWN" && !_stopping)
+		stopWorkers();
+	if (typeEnd == std::string::npos)
+		return ;
+	target = msg.substr(typeEnd + 1, targetEnd - typeEnd - 1);
+	if (targetEnd != std::string::npos)
+		param = msg.substr(targetEnd + 1);
+
+	// nicknames are kept in lower case (RFC1459:2.2), "Bob" and "bob" have one owner
+	std::string								nick = ircCasefold(target);
+	std::map<std::string, int>::iterator	owner = _nicks.find(nick);
+
+	if (type == "CLAIM")
+	{
+		std::string	previous = ircCasefold(param);
+
+		if (owner != _nicks.end() && owner->second != id)
+		{
+			send(id, "TAKEN " + target);
+			return ;
+		}
+
+		// a nickname change (or a case change) keeps the client in the channels of the others
+		std::map<std::string, int>::iterator	old = _nicks.find(previous);
+
+		if (old != _nicks.end() && old->second == id)
+		{
+			_nicks.erase(old);
+			_names.erase(previous);
+			_nicks[nick] = id;
+			_names[nick] = target;
+			broadcast(id, "RENAME " + previous + " " + target);
+		}
+		else
+		{
+			_nicks[nick] = id;
+			_names[nick] = target;
+			broadcast(id, "OWN " + target);
+		}
+		send(id, "CLAIMED " + target);
+	}
+	else if (type == "RELEASE" && owner != _nicks.end() && owner->second == id)
+	{
+		_nicks.erase(owner);
+		_names.erase(nick);
+		broadcast(id, "DROP " + nick + " " + param);
+	}
+	else if ((type == "USER" || type == "CHAN") && owner != _nicks.end() && owner->second != id)
+		send(owner->second, msg);
+	else if (type == "FWD" && target == "*")
+		broadcast(id, msg);
+	else if (type == "FWD")
+	{
+		int	channelOwner = std::atoi(target.c_str());
+
+		if (channelOwner >= 0 && channelOwner < _nbOfWorkers && channelOwner != id)
+			send(channelOwner, msg);
+	}
+}
+
+/**
+ * @brief Sends a message to a worker without blocking, it is queued if the worker's Bus is full
+ *
+ * @note The queue is sent in order when the Bus is writable again (see flushQueue()).
+ * Nicknames ownership and answers are always kept. Lines for the clients and
+ * forwarded commands (USER, FWD) are dropped once BUS_QUEUE_MAX bytes are waiting: a stuck worker must not make
+ * the Supervisor grow without limit.
+ */
+void	Supervisor::send(int id, std::string const &msg)
+{
+	if (_buses[id] == ERROR)
+		return ;
+	if (_queues[id].empty() && write(id, msg))
+		return ;
+	if (_queuedBytes[id] >= BUS_QUEUE_MAX && (msg.compare(0, 5, "USER ") == 0 || msg.compare(0, 4, "FWD ") == 0))
+	{
+		msg_log(MSG_SUP_BUS_FULL(id));
+		return ;
+	}
+	if (_queues[id].empty())
+		_poller->modify(_buses[id], POLLIN | POLLOUT);
+	_queues[id].push_back(msg);
+	_queuedBytes[id] += msg.size();
+}
+
+/**
+ * @brief Sends the messages queued for a worker, until its Bus is full again
+ */
+void	Supervisor::flushQueue(int id)
+{
+	while (!_queues[id].empty() && write(id, _queues[id].front()))
+	{
+		_queuedBytes[id] -= _queues[id].front().size();
+		_queues[id].pop_front();
+	}
+	if (_queues[id].empty() && _buses[id] != ERROR)
+		_poller->modify(_buses[id], POLLIN);
+}
+
+/**
+ * @brief One message on a worker's Bus
+ *
+ * @return false if the Bus is full. A message for a worker that is gone is
+ * considered sent (the worker is handled once reaped, see handleWorkerExit()).
+ */
+bool	Supervisor::write(int id, std::string const &msg)
+{
+	while (::send(_buses[id], msg.data(), msg.size(), MSG_DONTWAIT | MSG_NOSIGNAL) == ERROR)
+	{
+		if (errno == EINTR)
+			continue ;
+		return (errno != EAGAIN && errno != EWOULDBLOCK);
+	}
+	return (true);
+}
+
+/**
+ * @brief Sends a message to every worker but the sender
+ */
+void	Supervisor::broadcast(int from, std::string const &msg)
+{
+	for (int id = 0; id < _nbOfWorkers; id++)
+	{
+		if (id != from)
+			send(id, msg);
+	}
+}
+
+/**
+ * @brief Closes a worker's Bus, what was queued for it is lost
+ */
+void	Supervisor::closeBus(int id)
+{
+	_queues[id].clear();
+	_queuedBytes[id] = 0;
+	if (_buses[id] == ERROR)
+		return ;
+	_poller->remove(_buses[id]);
+	close(_buses[id]);
+	_buses[id] = ERROR;
+}
+
+/**
+ * @brief Asks every running worker to leave (they handle SIGINT like a standalone Server)
+ */
+void	Supervisor::stopWorkers()
+{
+	_stopping = true;
+	for (int id = 0; id < _nbOfWorkers; id++)
+	{
+		if (_pids[id] != ERROR)
+			kill(_pids[id], SIGINT);
+	}
+}
+
+bool	Supervisor::hasWorkers() const
+{
+	for (int id = 0; id < _nbOfWorkers; id++)
+	{
+		if (_pids[id] != ERROR)
+			return (true);
+	}
+	return (false);
+}
+
+/* #endregion */
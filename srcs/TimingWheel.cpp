@@ -0,0 +1,138 @@
+#include "ft_irc.hpp"
+
+/* #region Constructor/Destructor */
+
+TimingWheel::TimingWheel(): _now(0)
+{
+	for (int level = 0; level < WHEEL_LEVELS; level++)
+	{
+		for (int slot = 0; slot < WHEEL_SLOTS; slot++)
+		{
+			_slots[level][slot].prev = &_slots[level][slot];
+			_slots[level][slot].next = &_slots[level][slot];
+		}
+	}
+}
+
+TimingWheel::~TimingWheel() {}
+/* #endregion */
+
+/* #region PUBLIC */
+
+/**
+ * @brief Arms (or moves) a timer
+ *
+ * @param expires tick at which it fires, at least the next one
+ */
+void	TimingWheel::arm(s_timer &timer, unsigned long expires)
+{
+	cancel(timer);
+	timer.expires = std::max(expires, _now + 1);
+	link(timer);
+}
+
+/**
+ * @brief Unlinks the timer, nothing is done if it isn't armed
+ */
+void	TimingWheel::cancel(s_timer &timer)
+{
+	if (timer.prev == NULL)
+		return ;
+	timer.prev->next = timer.next;
+	timer.next->prev = timer.prev;
+	timer.prev = NULL;
+	timer.next = NULL;
+}
+
+/**
+ * @brief Moves the wheel forward
+ *
+ * @param ticks number of ticks elapsed
+ * @param expired filled with the FDs of the timers that fired (they are not armed anymore)
+ */
+void	TimingWheel::advance(unsigned long ticks, std::vector<int> &expired)
+{
+	for (unsigned long i = 0; i < ticks; i++)
+	{
+		int	level = 0;
+
+		_now++;
+
+		// highest level wrapping on this tick, spread from the top
+		while (level + 1 < WHEEL_LEVELS && (_now & ((1UL << (WHEEL_BITS * (level + 1))) - 1)) == 0)
+			level++;
+		for (; level > 0; level--)
+			cascade(level);
+
+		s_timer	&head = _slots[0][_now & (WHEEL_SLOTS - 1)];
+
+		while (head.next != &head)
+		{
+			s_timer	*timer = head.next;
+
+			cancel(*timer);
+			expired.push_back(timer->fd);
+		}
+	}
+}
+
+unsigned long	TimingWheel::getNow() const { return _now; }
+
+/**
+ * @brief Initializes a timer owned by a client, not armed
+ */
+void	TimingWheel::init(s_timer &timer, int fd)
+{
+	timer.prev = NULL;
+	timer.next = NULL;
+	timer.expires = 0;
+	timer.fd = fd;
+}
+
+/* #endregion */
+
+/* #region PRIVATE */
+
+/**
+ * @brief Links the timer in the slot matching its delay
+ * @note Delays beyond the last level are shortened to its range.
+ */
+void	TimingWheel::link(s_timer &timer)
+{
+	unsigned long	delay = timer.expires > _now ? timer.expires - _now : 0;
+	unsigned long	range = 1UL << (WHEEL_BITS * WHEEL_LEVELS);
+	int				level = 0;
+
+	if (delay >= range)
+	{
+		timer.expires = _now + range - 1;
+		delay = range - 1;
+	}
+	while (level + 1 < WHEEL_LEVELS && delay >= (1UL << (WHEEL_BITS * (level + 1))))
+		level++;
+
+	s_timer	&head = _slots[level][(timer.expires >> (WHEEL_BITS * level)) & (WHEEL_SLOTS - 1)];
+
+	timer.prev = head.prev;
+	timer.next = &head;
+	head.prev->next = &timer;
+	head.prev = &timer;
+}
+
+/**
+ * @brief Spreads the timers of the current slot of a level on the levels below
+ */
+void	TimingWheel::cascade(int level)
+{
+	s_timer	&head = _slots[level][(_now >> (WHEEL_BITS * level)) & (WHEEL_SLOTS - 1)];
+
+	while (head.next != &head)
+	{
+		s_timer	*timer = head.next;
+
+		cancel(*timer);
+		link(*timer);
+	}
+}
+
+/* #endregion */
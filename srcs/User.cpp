@@ -9,23 +9,35 @@
  * @param clientHostname hostname of the client
  */
 User::User(Server *server, int clientSocket, std::string const &clientHostname):
-	_server(server), _socket_fd(clientSocket), _hostname(clientHostname), _op(false)
+	_server(server), _reactor(NULL), _socket_fd(clientSocket), _hostname(clientHostname), _op(false),
+	_hostPending(false), _registrationPending(false), _nickPending(false), _remote(false), _sendQOffset(0), _sendQBytes(0), _outputWatched(false), _flushScheduled(false),
+	_sendQPeak(0), _evicted(false), _quitting(false)
 {
+	pthread_mutex_init(&_sendLock, NULL);
+	_commandQueue.first = 0;
+	_commandQueue.count = 0;
+	_commandQueue.scheduled = false;
+	_commandQueue.stalled = false;
+	TimingWheel::init(_keepalive.timer, clientSocket);
+	_flood.penaltyUntil = 0;
+	_flood.throttled = false;
+	_flood.resumeAt = 0;
+	_flood.exempt = false;
 	_status = CREATED;
 	_nickname = "*";
 	_username = "*";
 	_realname = "*";
 	_leavingMsg = "*";
-	_joinedChannels.clear();
-	_invitedChannels.clear();
+	updateFullname();
+	_memberships.clear();
 }
 
 User::~User()
 {
-	// Diseappears from all channel's invitation list
-	for (channel_iterator it = _invitedChannels.begin(); it != _invitedChannels.end(); it++)
-		(*it)->removeUser(this);
-	_invitedChannels.clear();
+	// Diseappears from all channel's invitation list (and channels not left yet)
+	while (!_memberships.empty())
+		_memberships.back()->channel->removeUser(this);
+	pthread_mutex_destroy(&_sendLock);
 }
 
 /* #endregion */
@@ -37,6 +49,50 @@ User::~User()
  */
 bool	User::isEmpty(std::string const &str) const { return str == "*"; }
 
+/**
+ * @brief Renders the prefix of the client's messages (see getFullname())
+ * @note Called by the setters of the nickname, username and hostname only.
+ */
+void	User::updateFullname()
+{
+	_fullname = _nickname;
+	if (!isEmpty(_username))
+		_fullname.append("!~").append(_username);
+	if (!isEmpty(_hostname))
+		_fullname.append("@").append(_hostname);
+}
+
+/**
+ * @brief Block of the SendQ where a message of len bytes (line ending included) can be appended
+ * @note Messages are packed in blocks: no allocation per message, and fewer buffers for sendmsg().
+ * Blocks shared with other clients are never written.
+ */
+std::string	&User::sendQBlock(size_t len)
+{
+	if (_sendQ.empty() || _sendQ.back().isShared() || _sendQ.back().size() + len > SENDQ_BLOCK)
+		_sendQ.push_back(SharedBuffer(std::max<size_t>(len, SENDQ_BLOCK)));
+	return (_sendQ.back().edit());
+}
+
+/**
+ * @brief Accounts a message appended to the SendQ, evicts the client or schedules the flush
+ */
+void	User::queued()
+{
+	if (_sendQBytes > _sendQPeak)
+		_sendQPeak = _sendQBytes;
+	if (_sendQBytes > getSendQMax())
+	{
+		__atomic_store_n(&_evicted, true, __ATOMIC_RELAXED);
+		_server->evictClient(this);
+		return ;
+	}
+	if (!_flushScheduled)
+	{
+		_reactor->scheduleFlush(_socket_fd);
+		_flushScheduled = true;
+	}
+}
 /* #endregion */
 
 /* #region Public */
@@ -45,13 +101,202 @@ bool	User::isEmpty(std::string const &str) const { return str == "*"; }
  * @brief Used to send a message to the client after formating it correctly
  * 
  * @param msg unformated message
+ * @note The message is queued: everything queued during a loop turn is sent at once
+ * when the turn ends (see flush()).
+ * @note A client whose queue exceeds its SendQ limit is evicted, nothing more is queued for it.
+ * @note The messages of a client of another worker go to it through the Supervisor.
+ * @note Shared commands (see isSharedCommand()) of several threads can send to the same
+ * client: the SendQ has its own lock.
  */
 void	User::sendToClient(std::string const &msg)
 {
-	std::string	fullMsg = msg + "\r\n";
-	
-	if (send(_socket_fd, fullMsg.c_str(), fullMsg.length(), 0) == ERROR)
-		MSG_ERR(strerror(errno));
+	if (_remote)
+	{
+		_server->sendToRemoteUser(_nickname, msg);
+		return ;
+	}
+
+	Lock	lock(_sendLock);
+
+	if (_evicted)
+		return ;
+	sendQBlock(msg.size() + 2).append(msg).append("\r\n", 2);
+	_sendQBytes += msg.size() + 2;
+	queued();
+}
+
+/**
+ * @brief Same as sendToClient(std::string const &), the reply is written directly in the SendQ
+ */
+void	User::sendToClient(Reply const &reply)
+{
+	if (_remote)
+	{
+		_server->sendToRemoteUser(_nickname, reply.str());
+		return ;
+	}
+
+	Lock	lock(_sendLock);
+
+	if (_evicted)
+		return ;
+
+	std::string	&block = sendQBlock(reply.size() + 2);
+
+	reply.appendTo(block);
+	block.append("\r\n", 2);
+	_sendQBytes += reply.size() + 2;
+	queued();
+}
+
+/**
+ * @brief Same as sendToClient(std::string const &), for a line rendered once for several clients
+ * @note The line isn't copied: the SendQ references it.
+ */
+void	User::sendToClient(SharedBuffer const &line)
+{
+	if (_remote)
+	{
+		_server->sendToRemoteUser(_nickname, line.line());
+		return ;
+	}
+
+	Lock	lock(_sendLock);
+
+	if (_evicted)
+		return ;
+	_sendQ.push_back(line);
+	_sendQBytes += line.size();
+	queued();
+}
+
+/**
+ * @brief Sends as much of the queued messages as the socket accepts
+ * 
+ * @return false if the connection is broken
+ * @note Used out of the loop turn's batch (disconnection): see beginFlush() and endFlush().
+ */
+bool	User::flush()
+{
+	s_send	send;
+
+	if (!beginFlush(send))
+		return (true);
+	Poller::sendNow(send);
+	return (endFlush(send));
+}
+
+/**
+ * @brief Locks the SendQ and gives its first blocks (up to SEND_IOV of them) to send,
+ * the Reactor sends them with the other clients' ones then calls endFlush()
+ *
+ * @return false if nothing is queued, the SendQ isn't locked then
+ * @note Called by the client's Reactor without the Server's lock: only the SendQ is used.
+ */
+bool	User::beginFlush(s_send &send)
+{
+	pthread_mutex_lock(&_sendLock);
+	_flushScheduled = false;
+	if (_sendQ.empty())
+	{
+		watchSendQ();
+		pthread_mutex_unlock(&_sendLock);
+		return (false);
+	}
+	prepareSend(send);
+	return (true);
+}
+
+/**
+ * @brief Removes what has been sent, sends the rest while the socket takes it, then unlocks
+ * the SendQ
+ *
+ * @param send filled by beginFlush(), its result set
+ * @return false if the connection is broken
+ * @note A partially sent block stays first in queue, POLLOUT is watched until the queue is empty.
+ */
+bool	User::endFlush(s_send &send)
+{
+	bool	isBroken = false;
+
+	while (true)
+	{
+		if (send.result == -EINTR)
+		{
+			Poller::sendNow(send);
+			continue ;
+		}
+		if (send.result == -EAGAIN || send.result == -EWOULDBLOCK)
+			break ;
+		if (send.result < 0)
+		{
+			MSG_ERR(strerror(-send.result));
+			isBroken = true;
+			break ;
+		}
+
+		// remove what has been sent
+		ssize_t	sent = send.result;
+
+		_sendQBytes -= sent;
+		while (sent > 0)
+		{
+			size_t	left = _sendQ.front().size() - _sendQOffset;
+
+			if (static_cast<size_t>(sent) < left)
+			{
+				_sendQOffset += sent;
+				break ;
+			}
+			sent -= left;
+			_sendQ.pop_front();
+			_sendQOffset = 0;
+		}
+
+		// everything is sent, or socket is full
+		if (_sendQ.empty() || send.msg.msg_iovlen < SEND_IOV)
+			break ;
+		prepareSend(send);
+		Poller::sendNow(send);
+	}
+	if (!isBroken)
+		watchSendQ();
+	pthread_mutex_unlock(&_sendLock);
+	return (!isBroken);
+}
+
+/**
+ * @brief Points the send's iovecs at the first blocks of the SendQ (_sendLock held)
+ */
+void	User::prepareSend(s_send &send)
+{
+	size_t	nbOfIov = 0;
+
+	for (std::deque<SharedBuffer>::iterator it = _sendQ.begin(); it != _sendQ.end() && nbOfIov < SEND_IOV; it++)
+	{
+		send.iov[nbOfIov].iov_base = const_cast<char *>(it->data());
+		send.iov[nbOfIov].iov_len = it->size();
+		nbOfIov++;
+	}
+	send.iov[0].iov_base = static_cast<char *>(send.iov[0].iov_base) + _sendQOffset;
+	send.iov[0].iov_len -= _sendQOffset;
+	memset(&send.msg, 0, sizeof(send.msg));
+	send.msg.msg_iov = send.iov;
+	send.msg.msg_iovlen = nbOfIov;
+	send.fd = _socket_fd;
+	send.result = 0;
+}
+
+/**
+ * @brief Watches POLLOUT while messages are queued (_sendLock held)
+ */
+void	User::watchSendQ()
+{
+	if (_sendQ.empty() != !_outputWatched)
+	{
+		_outputWatched = !_sendQ.empty();
+		_reactor->watchOutput(_socket_fd, _outputWatched);
+	}
 }
 
 void	User::welcome()
@@ -62,27 +307,61 @@ void	User::welcome()
 	sendToClient(RPL_MYINFO(_nickname));
 }
 
+/**
+ * @brief Last step of registration (NICK and USER accepted): the client is welcomed,
+ * or will be once its hostname is resolved.
+ */
+void	User::completeRegistration()
+{
+	if (_hostPending)
+	{
+		_registrationPending = true;
+		return ;
+	}
+	_registrationPending = false;
+	_status = REGISTERED;
+	welcome();
+}
+
 /* #endregion */
 
 /* #region Channel */
 
-void	User::addJoinedChannel(Channel *channel)	{ _joinedChannels.push_back(channel); }
-void	User::addInvitedChannel(Channel *channel)	{ _invitedChannels.push_back(channel); }
+/**
+ * @brief Keeps a link to a channel (called by the Channel, see Channel::addStatus())
+ */
+void	User::attach(s_membership *membership)
+{
+	membership->userSlot = _memberships.size();
+	_memberships.push_back(membership);
+}
 
-void	User::removeJoinedChannel(Channel *channel)
+/**
+ * @brief Forgets a link to a channel, the last one takes its place
+ */
+void	User::detach(s_membership *membership)
 {
-	channel_iterator	it = std::find(_joinedChannels.begin(), _joinedChannels.end(), channel);
-	if (it != _joinedChannels.end())
-		_joinedChannels.erase(it);
+	s_membership	*last = _memberships.back();
+
+	_memberships[membership->userSlot] = last;
+	last->userSlot = membership->userSlot;
+	_memberships.pop_back();
 }
 
-void	User::removeInvitedChannel(Channel *channel)
+/**
+ * @brief Multi-process mode: the client joined or left a channel of another worker
+ * (CHAN, see Server::trackRemoteMember())
+ */
+void	User::setRemoteChannel(std::string const &channel, bool isJoined)
 {
-	channel_iterator	it = std::find(_invitedChannels.begin(), _invitedChannels.end(), channel);
-	if (it != _invitedChannels.end())
-		_invitedChannels.erase(it);
+	if (isJoined)
+		_remoteChannels.insert(channel);
+	else
+		_remoteChannels.erase(channel);
 }
 
+std::set<std::string>	&User::getRemoteChannels() { return (_remoteChannels); }
+
 /**
  * @brief Leaves the given channel, display then clears the leaving message
  */
@@ -101,19 +380,16 @@ void	User::leaveChannel(Channel *channel, User *origin, std::string const &why)
 		if (isEmpty(_leavingMsg))
 		{
 			channel->sendToChannel(NULL, SEND_KICK(origin->getFullname(), channel->getChannelName(), _nickname, origin->getNickname()));
-			msg_log(_nickname + " has been kicked from " + channel->getChannelName());
+			msg_log(MSG_CHAN_KICKED, _socket_fd, _nickname, channel->getChannelName());
 		}
 		else
 		{
 			channel->sendToChannel(NULL, SEND_KICK(origin->getFullname(), channel->getChannelName(), _nickname, _leavingMsg));
-			msg_log(_nickname + " has been kicked from " + channel->getChannelName() + " :" + _leavingMsg);
+			msg_log((MSG_CHAN_KICKED " :" + _leavingMsg).c_str(), _socket_fd, _nickname, channel->getChannelName());
 		}
 	}
 
-	// remove channel from joined list
-	removeJoinedChannel(channel);
-
-	// remove user from the channel
+	// remove user from the channel (both sides are unlinked)
 	channel->removeUser(this);
 
 	// clean the leaving message
@@ -128,10 +404,13 @@ void	User::leaveChannel(Channel *channel, User *origin, std::string const &why)
  */
 void	User::leaveAllChannels(std::string const &why)
 {
-	channel_iterator it = _joinedChannels.begin();
-	while (it != _joinedChannels.end())
+	// from the last link: the ones moved by detach() were already seen (invitations)
+	for (size_t i = _memberships.size(); i-- > 0;)
 	{
-		Channel	*channel = *it;
+		Channel	*channel = _memberships[i]->channel;
+
+		if (!(_memberships[i]->status & MEMBER_JOINED))
+			continue ;
 
 		// If no leaving message was set
 		if (isEmpty(_leavingMsg))
@@ -149,16 +428,12 @@ void	User::leaveAllChannels(std::string const &why)
 			else
 				channel->sendToChannel(this, SEND_QUIT_MSG(getFullname(), _leavingMsg));
 		}
-		// remove channel from _joinedChannel list
-		it = _joinedChannels.erase(it);
-
-		// remove user from channel (if last user -> channel will be deleted)
+		// remove user from channel, both sides are unlinked (if last user -> channel will be deleted)
 		channel->removeUser(this);
 	}
 
 	// restore values to default
 	_leavingMsg = "*";
-	_joinedChannels.clear();
 }
 
 /* #endregion */
@@ -166,31 +441,82 @@ void	User::leaveAllChannels(std::string const &why)
 /* #region GETTERS */
 
 bool				User::isServerOp() const	{ return _op; }
+Reactor				*User::getReactor() const	{ return _reactor; }
+bool				User::isHostPending() const	{ return _hostPending; }
+bool				User::isRegistrationPending() const	{ return _registrationPending; }
+/**
+ * @brief Lines after the current one wait: registration or nickname claim not ended
+ */
+bool				User::isWaiting() const		{ return (_registrationPending || _nickPending); }
+bool				User::isRemote() const		{ return _remote; }
+LineBuffer			&User::getInput()			{ return _input; }
+size_t				User::getSendQBytes() const	{ return _sendQBytes; }
+size_t				User::getSendQPeak() const	{ return _sendQPeak; }
+size_t				User::getSendQMax() const	{ return (_op ? SENDQ_MAX_OPER : SENDQ_MAX); }
+bool				User::isEvicted() const		{ return __atomic_load_n(&_evicted, __ATOMIC_RELAXED); }
+bool				User::isDisconnecting() const	{ return (isEvicted() || _quitting); }
+bool				User::isOutputWatched() const	{ return _outputWatched; }
+s_commandQueue		&User::getCommandQueue()	{ return _commandQueue; }
+s_keepalive			&User::getKeepalive()		{ return _keepalive; }
+s_flood				&User::getFlood()			{ return _flood; }
 int 				User::getSocketFd() const	{ return _socket_fd; }
 clientStatus		User::getStatus() const		{ return _status; }
 std::string const	&User::getUsername() const	{ return _username; }
 std::string	const	&User::getNickname() const	{ return _nickname; }
 std::string const	&User::getRealname() const	{ return _realname; }
 std::string const	&User::getHostname() const	{ return _hostname; }
-std::string			User::getFullname() const
-{
-	std::string fullMsg = _nickname;
-	fullMsg += isEmpty(_username) ? "" : "!~" +_username;
-	fullMsg += isEmpty(_hostname) ? "" : "@" +_hostname;
-
-	return (fullMsg);
-}
+/**
+ * @brief Prefix of the client's messages: nick!~user@host
+ * @note Rendered once (see updateFullname()), the reference stays valid until the client is deleted.
+ */
+std::string const	&User::getFullname() const	{ return _fullname; }
+std::string const	&User::getLeavingMessage() const	{ return _leavingMsg; }
 
 /* #endregion */
 
 /* #region SETTERS */
 
+void	User::setReactor(Reactor *reactor)				{ _reactor = reactor; }
 void	User::setStatus(clientStatus status)			{ _status = status; }
-void	User::setUsername(std::string const &username)	{ _username = username; }
-void	User::setNickname(std::string const &nickname)	{ _nickname = nickname; }
+void	User::setUsername(std::string const &username)	{ _username = username; updateFullname(); }
 void	User::setRealname(std::string const &realname)	{ _realname = realname; }
-void	User::setHostname(std::string const &hostname)	{ _hostname = hostname; }
+void	User::setHostname(std::string const &hostname)	{ _hostname = hostname; updateFullname(); }
 void	User::setLeavingMessage(std::string const &msg)	{ _leavingMsg = msg; }
-void	User::setServerOP(bool val)						{ _op = val; }
+void	User::setQuitting()								{ _quitting = true; }
+void	User::setHostPending(bool val)					{ _hostPending = val; }
+void	User::setNickPending(bool val)					{ _nickPending = val; }
+void	User::setRemote()								{ _remote = true; }
+
+/**
+ * @brief Changes the nickname, the Server's index follows (see Server::getUserWithNickname())
+ */
+void	User::setNickname(std::string const &nickname)
+{
+	_server->indexNickname(this, nickname);
+	_nickname = nickname;
+	updateFullname();
+}
+
+/**
+ * @brief Hostname resolution ended, finishes the registration if it was waiting
+ */
+void	User::setResolvedHostname(std::string const &hostname)
+{
+	_hostname = hostname;
+	updateFullname();
+	_hostPending = false;
+	if (_registrationPending)
+		completeRegistration();
+}
+
+/**
+ * @brief Server operator status, operators can be exempted from flood control (FLOOD_EXEMPT_OPER)
+ */
+void	User::setServerOP(bool val)
+{
+	_op = val;
+	if (FLOOD_EXEMPT_OPER && _reactor)
+		_reactor->setFloodExempt(this, val);
+}
 
 /* #endregion */
\ No newline at end of file
@@ -2,11 +2,15 @@
 
 int	main(int ac, char **av)
 {
+	int	status = EXIT_SUCCESS;
+
 	try
 	{
 		if (ac != 3)
 			throw std::invalid_argument(ERR_SVR_USAGE(std::string(av[0])));
 
+		Logger::start();
+
 		Server	ircserv(av[1], av[2]);
 
 		ircserv.start();
@@ -14,7 +18,8 @@ int	main(int ac, char **av)
 	catch (const std::exception& e)
 	{
 		MSG_ERR(e.what());
-		return (EXIT_FAILURE);
+		status = EXIT_FAILURE;
 	}
-	return (EXIT_SUCCESS);
+	Logger::stop();
+	return (status);
 }
\ No newline at end of file
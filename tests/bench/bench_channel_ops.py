@@ -0,0 +1,72 @@
+"""Channel commands throughput: each client joins its own channel, changes its modes and
+parts it, again and again. These commands take the Server's lock exclusively (see
+isSharedCommand()), so they are executed one at a time in a process whatever the number
+of reactors and executor threads: only processes (IRC_PROCESSES, each with its own lock
+and channels) execute them side by side.
+Run with the reactors, executor threads and processes to compare, e.g. 1 0 1 4 4 1"""
+
+import os
+import selectors
+import sys
+import time
+
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), "..", "integration"))
+from irc import Server, Client  # noqa: E402
+
+CLIENTS = 16
+ROUNDS = 1000
+COMMANDS = 4        # per round: JOIN (answered with 3 lines), MODE +t, MODE -t, PART
+
+
+def registered(server, nick):
+    """operators: not throttled"""
+    client = Client(server, nick)
+    client.send("OPER bs 42")
+    client.expect(b" 381 ")
+    return client
+
+
+def answer(clients, expected):
+    """reads the clients until each one received expected lines"""
+    selector = selectors.DefaultSelector()
+    left = {}
+    for client in clients:
+        client.sock.setblocking(False)
+        selector.register(client.sock, selectors.EVENT_READ, client)
+        left[client] = expected
+    while left:
+        events = selector.select(timeout=10)
+        assert events, "no answer for 10 s"
+        for key, _ in events:
+            client = key.data
+            chunk = client.sock.recv(1 << 20)
+            assert chunk, "client disconnected"
+            left[client] -= chunk.count(b"\n")
+            if left[client] <= 0:
+                selector.unregister(client.sock)
+                del left[client]
+    selector.close()
+
+
+def bench(reactors, workers, processes):
+    env = {"IRC_REACTORS": reactors, "IRC_WORKERS": workers, "IRC_PROCESSES": processes, "IRC_LOG_LEVEL": "error"}
+    with Server(**env) as server:
+        if processes > 1:
+            server.wait_workers(processes)
+        clients = [registered(server, "c%d" % i) for i in range(CLIENTS)]
+        start = time.time()
+        for i, client in enumerate(clients):
+            # JOIN of an empty channel: the JOIN, NAMES and end of NAMES lines, PART: one line
+            client.send_raw(b"".join(b"JOIN #c%d\r\nMODE #c%d +t\r\nMODE #c%d -t\r\nPART #c%d\r\n" % (i, i, i, i)
+                                     for _ in range(ROUNDS)))
+        answer(clients, ROUNDS * (COMMANDS + 2))
+        elapsed = time.time() - start
+        commands = CLIENTS * ROUNDS * COMMANDS
+        print("reactors=%d workers=%d processes=%d: %d channel commands in %.3f s, %.0f commands/s, %.1f us each"
+              % (reactors, workers, processes, commands, elapsed, commands / elapsed, elapsed / commands * 1e6))
+
+
+if __name__ == "__main__":
+    args = [int(arg) for arg in sys.argv[1:]] or [1, 0, 1, 4, 0, 1, 4, 4, 1, 1, 0, 4]
+    for i in range(0, len(args) - 2, 3):
+        bench(args[i], args[i + 1], args[i + 2])
@@ -0,0 +1,77 @@
+"""Commands throughput with the Executor (IRC_WORKERS): senders flood a channel at once,
+the time until every member received every message gives the PRIVMSG delivered per second.
+Run with the number of reactors and executor threads to compare, e.g. 1 0, 2 4"""
+
+import os
+import selectors
+import sys
+import time
+
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), "..", "integration"))
+from irc import Server, Client  # noqa: E402
+
+SENDERS = 8
+MEMBERS = 32
+LINES = 2000
+ROUNDS = 3
+
+
+def registered(server, nick):
+    """operators: not throttled, and a SendQ large enough for the burst"""
+    client = Client(server, nick)
+    client.send("OPER bs 42", "JOIN #bench")
+    client.expect(b" 366 ")
+    return client
+
+
+def deliver(members, expected):
+    """reads the members until each one received expected lines"""
+    selector = selectors.DefaultSelector()
+    left = {}
+    for member in members:
+        member.sock.setblocking(False)
+        selector.register(member.sock, selectors.EVENT_READ, member)
+        left[member] = expected
+    while left:
+        for key, _ in selector.select(timeout=10):
+            member = key.data
+            chunk = member.sock.recv(1 << 20)
+            assert chunk, "member disconnected"
+            left[member] -= chunk.count(b"\n")
+            if left[member] <= 0:
+                selector.unregister(member.sock)
+                del left[member]
+    selector.close()
+
+
+def bench(reactors, workers):
+    with Server(IRC_REACTORS=reactors, IRC_WORKERS=workers, IRC_LOG_LEVEL="error") as server:
+        members = [registered(server, "m%d" % i) for i in range(MEMBERS)]
+        senders = [registered(server, "s%d" % i) for i in range(SENDERS)]
+        time.sleep(0.5)
+        for member in members:
+            member.received(b"")		# joins of the others
+            member.data = b""
+        burst = b"".join(b"PRIVMSG #bench :%06d the quick brown fox jumps over the lazy dog\r\n" % i
+                         for i in range(LINES))
+        best = None
+        for _ in range(ROUNDS):
+            start = time.time()
+            for sender in senders:
+                sender.send_raw(burst)
+            deliver(members, SENDERS * LINES)
+            elapsed = time.time() - start
+            best = elapsed if best is None else min(best, elapsed)
+            for sender in senders:		# their own channel's lines are not echoed
+                sender.received(b"")
+            for member in members:
+                member.sock.setblocking(True)
+        delivered = SENDERS * LINES * MEMBERS
+        print("reactors=%d workers=%d: %d PRIVMSG to %d members in %.3f s, %.0f deliveries/s"
+              % (reactors, workers, SENDERS * LINES, MEMBERS, best, delivered / best))
+
+
+if __name__ == "__main__":
+    args = [int(arg) for arg in sys.argv[1:]] or [1, 0, 1, 4, 2, 4]
+    for i in range(0, len(args) - 1, 2):
+        bench(args[i], args[i + 1])
@@ -0,0 +1,164 @@
+/*
+ * CPU and heap allocations of a PRIVMSG to a channel of 10, 1k and 10k members:
+ * Channel::sendToChannel() renders the line once in a SharedBuffer queued by every
+ * member, versus the line formatted in each member's SendQ (as before).
+ * Members write to one socket, whose other end is read by a thread; the SendQs
+ * are flushed between the measured fanouts.
+ */
+
+#include "ft_irc.hpp"
+#include <new>
+
+#define DELIVERIES	1000000		// per channel size: rounds = DELIVERIES / members
+#define FLUSH_EVERY	16			// fanouts queued before the members are flushed
+
+static size_t	g_allocations = 0;
+
+// counts the allocations, the default operator delete frees them (malloc'd by libstdc++'s too)
+void	*operator new(size_t size) throw(std::bad_alloc)
+{
+	void	*ptr = malloc(size ? size : 1);
+
+	if (ptr == NULL)
+		throw std::bad_alloc();
+	g_allocations++;
+	return (ptr);
+}
+
+static double	now()
+{
+	timespec	ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (ts.tv_sec + ts.tv_nsec / 1e9);
+}
+
+/**
+ * @brief Reads and drops what the members send, until the socket is closed
+ */
+static void	*sink(void *fd)
+{
+	char	buffer[1 << 16];
+
+	while (read(*static_cast<int *>(fd), buffer, sizeof(buffer)) > 0)
+		;
+	return (NULL);
+}
+
+static void	flushAll(std::vector<User *> &members)
+{
+	for (std::vector<User *>::iterator it = members.begin(); it != members.end(); it++)
+	{
+		while ((*it)->getSendQBytes() != 0)
+			(*it)->flush();
+	}
+}
+
+static void	report(char const *name, double elapsed, size_t allocations, size_t rounds, size_t members)
+{
+	std::cout << "  " << name << static_cast<long>(elapsed * 1e9 / rounds) << " ns/fanout, "
+		<< static_cast<long>(elapsed * 1e9 / (rounds * (members - 1))) << " ns/member, "
+		<< static_cast<double>(allocations) / rounds << " allocations/fanout" << std::endl;
+}
+
+/**
+ * @note The members are indexed by the Server (nicknames): they are deleted after it.
+ */
+static void	bench(int fd, size_t size)
+{
+	Server				*server = new Server("6667", "pw");
+	Reactor				reactor(server, 0, "poll");
+	std::vector<User *>	members;
+
+	for (size_t i = 0; i < size; i++)
+	{
+		User	*user = new User(server, fd, "client.example.net");
+
+		user->setReactor(&reactor);
+		user->setNickname("member" + to_string(i));
+		user->setUsername("guest");
+		user->setStatus(REGISTERED);
+		members.push_back(user);
+	}
+
+	// JOINs are sent to the members already there: flushed from time to time
+	Channel	*channel = new Channel(server, "#bench", members[0]);
+
+	for (size_t i = 1; i < size; i++)
+	{
+		channel->addUser(members[i], NORMAL);
+		if (i % 256 == 0)
+			flushAll(members);
+	}
+	flushAll(members);
+
+	User		*sender = members[0];
+	std::string	text = "the quick brown fox jumps over the lazy dog";
+	size_t		rounds = DELIVERIES / size;
+	double		shared = 0;
+	double		copied = 0;
+	size_t		sharedAllocations = 0;
+	size_t		copiedAllocations = 0;
+
+	for (size_t round = 0; round < rounds; round++)
+	{
+		size_t	allocations = g_allocations;
+		double	start = now();
+
+		channel->sendToChannel(sender, SEND_PM(sender->getFullname(), "#bench", text));
+		shared += now() - start;
+		sharedAllocations += g_allocations - allocations;
+		if (round % FLUSH_EVERY == FLUSH_EVERY - 1)
+			flushAll(members);
+	}
+	flushAll(members);
+
+	for (size_t round = 0; round < rounds; round++)
+	{
+		size_t	allocations = g_allocations;
+		double	start = now();
+
+		for (std::vector<User *>::iterator it = members.begin(); it != members.end(); it++)
+		{
+			if (*it != sender)
+				(*it)->sendToClient(SEND_PM(sender->getFullname(), "#bench", text));
+		}
+		copied += now() - start;
+		copiedAllocations += g_allocations - allocations;
+		if (round % FLUSH_EVERY == FLUSH_EVERY - 1)
+			flushAll(members);
+	}
+	flushAll(members);
+
+	std::cout << size << " members (" << rounds << " fanouts):" << std::endl;
+	report("shared:    ", shared, sharedAllocations, rounds, size);
+	report("per member:", copied, copiedAllocations, rounds, size);
+
+	delete channel;
+	delete server;
+	for (std::vector<User *>::iterator it = members.begin(); it != members.end(); it++)
+		delete *it;
+}
+
+int	main()
+{
+	int			fds[2];
+	pthread_t	thread;
+	size_t		sizes[] = {10, 1000, 10000};
+
+	setenv("IRC_LOG_LEVEL", "off", 0);
+	Logger::start();
+	if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) == ERROR
+		|| pthread_create(&thread, NULL, &sink, &fds[1]) != 0)
+	{
+		std::cout << strerror(errno) << std::endl;
+		return (EXIT_FAILURE);
+	}
+	for (size_t i = 0; i < sizeof(sizes) / sizeof(*sizes); i++)
+		bench(fds[0], sizes[i]);
+	close(fds[0]);
+	pthread_join(thread, NULL);
+	close(fds[1]);
+	Logger::stop();
+	return (EXIT_SUCCESS);
+}
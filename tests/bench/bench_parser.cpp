@@ -0,0 +1,144 @@
+/*
+ * Lines parsed per second, and heap allocations per line, of Server::parseLine
+ * versus the std::istringstream parser it replaced (kept below as it was).
+ */
+
+#include "ft_irc.hpp"
+#include <new>
+
+#define ROUNDS	200000
+
+static size_t	g_allocations = 0;
+
+// counts the allocations, the default operator delete frees them (malloc'd by libstdc++'s too)
+void	*operator new(size_t size) throw(std::bad_alloc)
+{
+	void	*ptr = malloc(size ? size : 1);
+
+	if (ptr == NULL)
+		throw std::bad_alloc();
+	g_allocations++;
+	return (ptr);
+}
+
+/* #region Previous parser */
+
+struct	s_oldMsg
+{
+	std::string					prefix;
+	std::string					cmd;
+	std::vector<std::string>	args;
+	std::string					trailing;
+	bool						trailing_sign;
+};
+
+static s_oldMsg	oldParseLine(std::string const &line)
+{
+	s_oldMsg			parsedMsg;
+	std::istringstream	iss(line);
+
+	parsedMsg.trailing_sign	= false;
+	if (line[0] == ':')
+	{
+		size_t	prefixEnd = line.find(' ');
+		if (prefixEnd != std::string::npos)
+		{
+				parsedMsg.prefix = line.substr(1, prefixEnd - 1);
+				iss.ignore(prefixEnd + 1);
+		}
+		else
+			return (parsedMsg);
+	}
+	iss >> parsedMsg.cmd;
+
+	std::string	arg;
+	while (iss >> arg)
+	{
+		if (arg[0] == ':')
+		{
+			parsedMsg.trailing_sign = true;
+			if (!parsedMsg.trailing.empty())
+				parsedMsg.trailing += ' ' + arg.substr(1);
+			else
+				parsedMsg.trailing = arg.substr(1);
+			while (iss >> arg)
+				parsedMsg.trailing += ' ' + arg;
+			break ;
+		}
+		else
+			parsedMsg.args.push_back(arg);
+	}
+	return (parsedMsg);
+}
+/* #endregion */
+
+static double	now()
+{
+	timespec	ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (ts.tv_sec + ts.tv_nsec / 1e9);
+}
+
+static void	report(char const *name, double elapsed, size_t allocations, size_t lines)
+{
+	std::cout << "  " << name << static_cast<long>(lines / elapsed) << " lines/s, "
+		<< static_cast<double>(allocations) / lines << " allocations/line" << std::endl;
+}
+
+int	main()
+{
+	Server		server("6667", "pw");
+	char const	*corpus[] = {
+		"PRIVMSG #bench :the quick brown fox jumps over the lazy dog",
+		":nick!user@host PRIVMSG #bench :hello there",
+		"MODE #bench +kl secret 42",
+		"JOIN #a,#b,#c key1,key2",
+		"PING :irc.example.net",
+		"USER guest 0 * :Real Name",
+		"NICK somebody",
+		"KICK #bench somebody :you know why",
+	};
+	size_t		nbOfLines = sizeof(corpus) / sizeof(*corpus);
+	std::string	longLine = "PRIVMSG #bench :" + std::string(400, 'x');
+	size_t		checksum = 0;
+
+	for (int pass = 0; pass < 2; pass++)
+	{
+		std::vector<std::string>	lines;
+
+		if (pass == 0)
+			lines.assign(corpus, corpus + nbOfLines);
+		else
+			lines.assign(1, longLine);
+		std::cout << (pass == 0 ? "common commands:" : "400 bytes PRIVMSG:") << std::endl;
+
+		size_t	allocations = g_allocations;
+		double	start = now();
+
+		for (int round = 0; round < ROUNDS; round++)
+		{
+			for (size_t i = 0; i < lines.size(); i++)
+			{
+				s_oldMsg	msg = oldParseLine(lines[i]);
+
+				checksum += msg.args.size() + msg.trailing.size();
+			}
+		}
+		report("istringstream: ", now() - start, g_allocations - allocations, ROUNDS * lines.size());
+
+		allocations = g_allocations;
+		start = now();
+		for (int round = 0; round < ROUNDS; round++)
+		{
+			for (size_t i = 0; i < lines.size(); i++)
+			{
+				s_msg	msg = server.parseLine(lines[i].data(), lines[i].size());
+
+				checksum += msg.args.size() + msg.trailing.size();
+			}
+		}
+		report("parseLine:     ", now() - start, g_allocations - allocations, ROUNDS * lines.size());
+	}
+	return (checksum == 0);
+}
@@ -0,0 +1,139 @@
+/*
+ * Replies per second, and heap allocations per reply, of the Reply macros of msg.hpp
+ * versus the std::string concatenations they replaced (kept below as they were),
+ * each queued the way User::sendToClient() did: a string per message before,
+ * appended to a SendQ block now.
+ */
+
+#include "ft_irc.hpp"
+#include <new>
+
+#define ROUNDS	200000
+
+static size_t	g_allocations = 0;
+
+// counts the allocations, the default operator delete frees them (malloc'd by libstdc++'s too)
+void	*operator new(size_t size) throw(std::bad_alloc)
+{
+	void	*ptr = malloc(size ? size : 1);
+
+	if (ptr == NULL)
+		throw std::bad_alloc();
+	g_allocations++;
+	return (ptr);
+}
+
+/* #region Previous macros */
+
+# define OLD_SVR_PREFIX to_string(":") + SVR_NAME
+# define OLD_RPL_WELCOME(nick, full)			OLD_SVR_PREFIX + " 001 " + nick + " :Welcome to the B&S IRC server " + full
+# define OLD_RPL_TOPIC(nick, chan, topic)		OLD_SVR_PREFIX + " 332 " + nick + " " + chan + " :" + topic
+# define OLD_RPL_NAMREPLY(nick, chan, list)		OLD_SVR_PREFIX + " 353 " + nick + " = " + chan + " :" + list
+# define OLD_RPL_ENDOFNAMES(nick, chan)			OLD_SVR_PREFIX + " 366 " + nick + " " + chan + " :End of /NAMES list."
+# define OLD_ERR_NOSUCHNICK(nick, target)		OLD_SVR_PREFIX + " 401 " + nick + " " + target + " :No such nick."
+# define OLD_ERR_NEEDMOREPARAMS(nick, cmd)		OLD_SVR_PREFIX + " 461 " + nick + " " + cmd + " :Need more parameters"
+# define OLD_SEND_PM(from, to, msg)				":" + from + " PRIVMSG " + to + " :" + msg
+# define OLD_SEND_JOIN(full, chan)				":" + full + " JOIN :" + chan
+/* #endregion */
+
+#define NB_OF_REPLIES 8
+
+static std::string const	g_nick = "somebody";
+static std::string const	g_full = "somebody!guest@client.example.net";
+static std::string const	g_chan = "#bench";
+static std::string const	g_topic = "what this channel is about";
+static std::string const	g_names = "@somebody other third fourth";
+static std::string const	g_text = "the quick brown fox jumps over the lazy dog";
+
+static std::string	oldReply(int i)
+{
+	switch (i)
+	{
+		case 0:	return (OLD_RPL_WELCOME(g_nick, g_full));
+		case 1:	return (OLD_RPL_TOPIC(g_nick, g_chan, g_topic));
+		case 2:	return (OLD_RPL_NAMREPLY(g_nick, g_chan, g_names));
+		case 3:	return (OLD_RPL_ENDOFNAMES(g_nick, g_chan));
+		case 4:	return (OLD_ERR_NOSUCHNICK(g_nick, "nobody"));
+		case 5:	return (OLD_ERR_NEEDMOREPARAMS(g_nick, "JOIN"));
+		case 6:	return (OLD_SEND_PM(g_full, g_chan, g_text));
+		default:	return (OLD_SEND_JOIN(g_full, g_chan));
+	}
+}
+
+/**
+ * @brief Appends the reply i and its line ending to block, as User::sendToClient(Reply const &)
+ */
+static void	newReply(int i, std::string &block)
+{
+	switch (i)
+	{
+		case 0:	RPL_WELCOME(g_nick, g_full).appendTo(block); break ;
+		case 1:	RPL_TOPIC(g_nick, g_chan, g_topic).appendTo(block); break ;
+		case 2:	RPL_NAMREPLY(g_nick, g_chan, g_names).appendTo(block); break ;
+		case 3:	RPL_ENDOFNAMES(g_nick, g_chan).appendTo(block); break ;
+		case 4:	ERR_NOSUCHNICK(g_nick, "nobody").appendTo(block); break ;
+		case 5:	ERR_NEEDMOREPARAMS(g_nick, "JOIN").appendTo(block); break ;
+		case 6:	SEND_PM(g_full, g_chan, g_text).appendTo(block); break ;
+		default:	SEND_JOIN(g_full, g_chan).appendTo(block); break ;
+	}
+	block.append("\r\n", 2);
+}
+
+static double	now()
+{
+	timespec	ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (ts.tv_sec + ts.tv_nsec / 1e9);
+}
+
+static void	report(char const *name, double elapsed, size_t allocations)
+{
+	size_t	replies = static_cast<size_t>(ROUNDS) * NB_OF_REPLIES;
+
+	std::cout << "  " << name << static_cast<long>(replies / elapsed) << " replies/s, "
+		<< static_cast<double>(allocations) / replies << " allocations/reply" << std::endl;
+}
+
+int	main()
+{
+	std::deque<std::string>	oldQueue;
+	std::string				block;
+
+	// same texts, byte for byte
+	for (int i = 0; i < NB_OF_REPLIES; i++)
+	{
+		block.clear();
+		newReply(i, block);
+		if (block != oldReply(i) + "\r\n")
+		{
+			std::cout << "reply " << i << " differs: " << block << std::endl;
+			return (EXIT_FAILURE);
+		}
+	}
+	block.clear();
+	block.reserve(SENDQ_BLOCK);
+
+	size_t	allocations = g_allocations;
+	double	start = now();
+
+	for (int round = 0; round < ROUNDS; round++)
+	{
+		for (int i = 0; i < NB_OF_REPLIES; i++)
+			oldQueue.push_back(oldReply(i) + "\r\n");
+		oldQueue.clear();		// flushed
+	}
+	report("std::string: ", now() - start, g_allocations - allocations);
+
+	allocations = g_allocations;
+	start = now();
+	for (int round = 0; round < ROUNDS; round++)
+	{
+		for (int i = 0; i < NB_OF_REPLIES; i++)
+			newReply(i, block);
+		if (block.size() > SENDQ_BLOCK - MSG_MAX_LEN)
+			block.clear();		// flushed
+	}
+	report("Reply:       ", now() - start, g_allocations - allocations);
+	return (EXIT_SUCCESS);
+}
@@ -0,0 +1,66 @@
+/*
+ * Scanner throughput of each implementation the CPU runs, on what the server scans:
+ * framing a burst of short lines ('\n') and framing long lines.
+ */
+
+#include "ft_irc.hpp"
+
+#define DATA_SIZE	(1 << 20)
+#define ROUNDS		200
+
+static double	now()
+{
+	timespec	ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (ts.tv_sec + ts.tv_nsec / 1e9);
+}
+
+/**
+ * @brief DATA_SIZE bytes of PRIVMSG lines whose text is lineLength bytes long
+ */
+static std::string	makeLines(size_t lineLength)
+{
+	std::string	data;
+
+	while (data.size() < DATA_SIZE)
+		data += "PRIVMSG #bench :" + std::string(lineLength, 'x') + "\r\n";
+	data.resize(DATA_SIZE);
+	return (data);
+}
+
+/**
+ * @brief MB/s of the lines found one after the other, as LineBuffer does
+ */
+static double	frame(Scanner::s_impl const &impl, std::string const &data, size_t &found)
+{
+	char const	*end = data.data() + data.size();
+	double		start = now();
+
+	found = 0;
+	for (int round = 0; round < ROUNDS; round++)
+	{
+		for (char const *it = data.data(); (it = impl.findByte(it, end, '\n')) != end; it++)
+			found++;
+	}
+	return (ROUNDS * (data.size() / 1e6) / (now() - start));
+}
+
+int	main()
+{
+	std::vector<Scanner::s_impl>	impls = Scanner::getImpls();
+	std::string		shortLines = makeLines(40);
+	std::string		longLines = makeLines(480);
+	size_t			found;
+
+	std::cout << "scanner selected: " << Scanner::getName() << std::endl;
+	for (std::vector<Scanner::s_impl>::iterator it = impls.begin(); it != impls.end(); it++)
+	{
+		std::cout << it->name << ":" << std::endl;
+		std::cout << "  60 bytes lines:  " << static_cast<int>(frame(*it, shortLines, found)) << " MB/s";
+		std::cout << " (" << found / ROUNDS << " lines)" << std::endl;
+		std::cout << "  500 bytes lines: " << static_cast<int>(frame(*it, longLines, found)) << " MB/s";
+		std::cout << " (" << found / ROUNDS << " lines)" << std::endl;
+	}
+	return (EXIT_SUCCESS);
+}
@@ -0,0 +1,85 @@
+"""Syscalls per reply, for each event loop engine: the server runs with count_syscalls.so
+preloaded, clients register (as operators, not throttled), join a channel one after the
+other, then all send a burst of PRIVMSG to it.
+Every line received by the clients is a reply. The syscalls are the reads and writes of
+the server on its sockets and the waits of its event loop (see count_syscalls.cpp), the
+sends alone are also given. Set IRCSERV to measure another build."""
+
+import os
+import socket
+import sys
+import tempfile
+import time
+
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), "..", "integration"))
+from irc import Server, PASSWORD  # noqa: E402
+
+CLIENTS = 20
+LINES = 50
+PRELOAD = os.path.join(os.path.dirname(__file__), "..", "..", "obj", "count_syscalls.so")
+
+
+def read_until(sock, data, done, timeout=10):
+    """reads into data (a list of chunks) until done(received bytes)"""
+    deadline = time.time() + timeout
+    while not done(b"".join(data)):
+        sock.settimeout(max(deadline - time.time(), 0.01))
+        chunk = sock.recv(65536)
+        assert chunk, "disconnected"
+        data.append(chunk)
+
+
+SENDS = ("send", "sendto", "sendmsg", "write", "writev")
+
+
+def bench(engine):
+    counts = tempfile.NamedTemporaryFile(delete=False)
+    counts.close()
+    env = {"LD_PRELOAD": os.path.abspath(PRELOAD), "COUNT_SYSCALLS_FILE": counts.name,
+           "IRC_LOG_LEVEL": "error", "IRC_ENGINE": engine}
+    with Server(**env) as server:
+        clients = []
+        for i in range(CLIENTS):
+            sock = socket.create_connection(("127.0.0.1", server.port), timeout=5)
+            data = []
+            sock.sendall(("PASS %s\r\nNICK c%d\r\nUSER c%d 0 * :c%d\r\nOPER bs 42\r\nJOIN #bench\r\n"
+                          % (PASSWORD, i, i, i)).encode())
+            read_until(sock, data, lambda received: b" 366 " in received)
+            clients.append((sock, data))
+
+        burst = b"".join(b"PRIVMSG #bench :line %d of the burst\r\n" % i for i in range(LINES))
+        for sock, _ in clients:
+            sock.sendall(burst)
+        for sock, data in clients:
+            read_until(sock, data, lambda received: received.count(b" PRIVMSG #bench ") == (CLIENTS - 1) * LINES)
+        time.sleep(0.2)
+        for sock, data in clients:
+            sock.setblocking(False)
+            try:
+                while True:
+                    chunk = sock.recv(65536)
+                    if not chunk:
+                        break
+                    data.append(chunk)
+            except BlockingIOError:
+                pass
+        replies = sum(b"".join(data).count(b"\n") for _, data in clients)
+        for sock, _ in clients:
+            sock.close()
+
+    calls = {}
+    with open(counts.name) as f:
+        for line in f:
+            name, count = line.split()
+            calls[name] = calls.get(name, 0) + int(count)
+    os.unlink(counts.name)
+    total = sum(calls.values())
+    sends = sum(calls.get(name, 0) for name in SENDS)
+    print("%-8s %d replies, %d syscalls (%s): %.3f syscalls per reply, %.3f sends per reply"
+          % (engine, replies, total, ", ".join("%s %d" % item for item in sorted(calls.items()) if item[1]),
+             float(total) / replies, float(sends) / replies))
+
+
+if __name__ == "__main__":
+    for engine in ("poll", "epoll", "io_uring"):
+        bench(engine)
@@ -0,0 +1,238 @@
+/*
+ * Preloaded in the server (LD_PRELOAD): counts the calls of the clients' I/O path,
+ * written at exit in $COUNT_SYSCALLS_FILE as "<function> <calls>" lines:
+ * - reads and writes on a socket (send, sendto, sendmsg, write, writev, recv, recvfrom,
+ *   recvmsg, read, accept, accept4, getpeername, ioctl),
+ * - waits of the event loop engines (poll, ppoll, epoll_wait, epoll_pwait, epoll_ctl,
+ *   io_uring_enter through syscall()).
+ * Used by bench_syscalls.py.
+ */
+
+#include <dlfcn.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+
+enum	e_call { CALL_SEND, CALL_SENDTO, CALL_SENDMSG, CALL_WRITE, CALL_WRITEV, CALL_RECV, CALL_RECVFROM,
+	CALL_RECVMSG, CALL_READ, CALL_ACCEPT, CALL_ACCEPT4, CALL_GETPEERNAME, CALL_IOCTL, CALL_POLL, CALL_PPOLL,
+	CALL_EPOLL_WAIT, CALL_EPOLL_PWAIT, CALL_EPOLL_CTL, CALL_IO_URING_ENTER, NB_OF_CALLS };
+
+static char const		*g_names[NB_OF_CALLS] = {"send", "sendto", "sendmsg", "write", "writev", "recv", "recvfrom",
+	"recvmsg", "read", "accept", "accept4", "getpeername", "ioctl", "poll", "ppoll",
+	"epoll_wait", "epoll_pwait", "epoll_ctl", "io_uring_enter"};
+static unsigned long	g_calls[NB_OF_CALLS];
+
+static void	count(e_call call)
+{
+	__atomic_add_fetch(&g_calls[call], 1, __ATOMIC_RELAXED);
+}
+
+// reads and writes are only counted on sockets (not on the eventfds, timerfds and log files)
+static void	count(e_call call, int fd)
+{
+	struct stat	info;
+
+	if (fstat(fd, &info) == 0 && S_ISSOCK(info.st_mode))
+		count(call);
+}
+
+/**
+ * @brief Writes the counts when the server exits (the workers of IRC_PROCESSES too,
+ * each one appends its own lines)
+ */
+static void	report()
+{
+	char const	*path = getenv("COUNT_SYSCALLS_FILE");
+	FILE		*file;
+
+	if (path == NULL || (file = fopen(path, "a")) == NULL)
+		return ;
+	for (int i = 0; i < NB_OF_CALLS; i++)
+		fprintf(file, "%s %lu\n", g_names[i], g_calls[i]);
+	fclose(file);
+}
+
+__attribute__((constructor))
+static void	init() { atexit(&report); }
+
+template <typename T>
+static T	next(char const *name) { return (reinterpret_cast<T>(dlsym(RTLD_NEXT, name))); }
+
+extern "C"
+{
+	ssize_t	send(int fd, void const *buf, size_t len, int flags)
+	{
+		static ssize_t	(*real)(int, void const *, size_t, int) = next<ssize_t (*)(int, void const *, size_t, int)>("send");
+
+		count(CALL_SEND, fd);
+		return (real(fd, buf, len, flags));
+	}
+
+	ssize_t	sendto(int fd, void const *buf, size_t len, int flags, sockaddr const *addr, socklen_t addrLen)
+	{
+		static ssize_t	(*real)(int, void const *, size_t, int, sockaddr const *, socklen_t)
+			= next<ssize_t (*)(int, void const *, size_t, int, sockaddr const *, socklen_t)>("sendto");
+
+		count(CALL_SENDTO, fd);
+		return (real(fd, buf, len, flags, addr, addrLen));
+	}
+
+	ssize_t	sendmsg(int fd, msghdr const *msg, int flags)
+	{
+		static ssize_t	(*real)(int, msghdr const *, int) = next<ssize_t (*)(int, msghdr const *, int)>("sendmsg");
+
+		count(CALL_SENDMSG, fd);
+		return (real(fd, msg, flags));
+	}
+
+	ssize_t	write(int fd, void const *buf, size_t len)
+	{
+		static ssize_t	(*real)(int, void const *, size_t) = next<ssize_t (*)(int, void const *, size_t)>("write");
+
+		count(CALL_WRITE, fd);
+		return (real(fd, buf, len));
+	}
+
+	ssize_t	writev(int fd, iovec const *iov, int iovcnt)
+	{
+		static ssize_t	(*real)(int, iovec const *, int) = next<ssize_t (*)(int, iovec const *, int)>("writev");
+
+		count(CALL_WRITEV, fd);
+		return (real(fd, iov, iovcnt));
+	}
+
+	ssize_t	recv(int fd, void *buf, size_t len, int flags)
+	{
+		static ssize_t	(*real)(int, void *, size_t, int) = next<ssize_t (*)(int, void *, size_t, int)>("recv");
+
+		count(CALL_RECV, fd);
+		return (real(fd, buf, len, flags));
+	}
+
+	ssize_t	recvfrom(int fd, void *buf, size_t len, int flags, sockaddr *addr, socklen_t *addrLen)
+	{
+		static ssize_t	(*real)(int, void *, size_t, int, sockaddr *, socklen_t *)
+			= next<ssize_t (*)(int, void *, size_t, int, sockaddr *, socklen_t *)>("recvfrom");
+
+		count(CALL_RECVFROM, fd);
+		return (real(fd, buf, len, flags, addr, addrLen));
+	}
+
+	ssize_t	recvmsg(int fd, msghdr *msg, int flags)
+	{
+		static ssize_t	(*real)(int, msghdr *, int) = next<ssize_t (*)(int, msghdr *, int)>("recvmsg");
+
+		count(CALL_RECVMSG, fd);
+		return (real(fd, msg, flags));
+	}
+
+	ssize_t	read(int fd, void *buf, size_t len)
+	{
+		static ssize_t	(*real)(int, void *, size_t) = next<ssize_t (*)(int, void *, size_t)>("read");
+
+		count(CALL_READ, fd);
+		return (real(fd, buf, len));
+	}
+
+	int	accept(int fd, sockaddr *addr, socklen_t *addrLen)
+	{
+		static int	(*real)(int, sockaddr *, socklen_t *) = next<int (*)(int, sockaddr *, socklen_t *)>("accept");
+
+		count(CALL_ACCEPT);
+		return (real(fd, addr, addrLen));
+	}
+
+	int	accept4(int fd, sockaddr *addr, socklen_t *addrLen, int flags)
+	{
+		static int	(*real)(int, sockaddr *, socklen_t *, int) = next<int (*)(int, sockaddr *, socklen_t *, int)>("accept4");
+
+		count(CALL_ACCEPT4);
+		return (real(fd, addr, addrLen, flags));
+	}
+
+	int	getpeername(int fd, sockaddr *addr, socklen_t *addrLen)
+	{
+		static int	(*real)(int, sockaddr *, socklen_t *) = next<int (*)(int, sockaddr *, socklen_t *)>("getpeername");
+
+		count(CALL_GETPEERNAME);
+		return (real(fd, addr, addrLen));
+	}
+
+	int	ioctl(int fd, unsigned long request, ...)
+	{
+		static int	(*real)(int, unsigned long, void *) = next<int (*)(int, unsigned long, void *)>("ioctl");
+		va_list		args;
+
+		va_start(args, request);
+		void	*arg = va_arg(args, void *);
+		va_end(args);
+		count(CALL_IOCTL, fd);
+		return (real(fd, request, arg));
+	}
+
+	int	poll(pollfd *fds, nfds_t nfds, int timeout)
+	{
+		static int	(*real)(pollfd *, nfds_t, int) = next<int (*)(pollfd *, nfds_t, int)>("poll");
+
+		count(CALL_POLL);
+		return (real(fds, nfds, timeout));
+	}
+
+	int	ppoll(pollfd *fds, nfds_t nfds, timespec const *timeout, sigset_t const *mask)
+	{
+		static int	(*real)(pollfd *, nfds_t, timespec const *, sigset_t const *)
+			= next<int (*)(pollfd *, nfds_t, timespec const *, sigset_t const *)>("ppoll");
+
+		count(CALL_PPOLL);
+		return (real(fds, nfds, timeout, mask));
+	}
+
+	int	epoll_wait(int epfd, epoll_event *events, int maxEvents, int timeout)
+	{
+		static int	(*real)(int, epoll_event *, int, int) = next<int (*)(int, epoll_event *, int, int)>("epoll_wait");
+
+		count(CALL_EPOLL_WAIT);
+		return (real(epfd, events, maxEvents, timeout));
+	}
+
+	int	epoll_pwait(int epfd, epoll_event *events, int maxEvents, int timeout, sigset_t const *mask)
+	{
+		static int	(*real)(int, epoll_event *, int, int, sigset_t const *)
+			= next<int (*)(int, epoll_event *, int, int, sigset_t const *)>("epoll_pwait");
+
+		count(CALL_EPOLL_PWAIT);
+		return (real(epfd, events, maxEvents, timeout, mask));
+	}
+
+	int	epoll_ctl(int epfd, int op, int fd, epoll_event *event)
+	{
+		static int	(*real)(int, int, int, epoll_event *) = next<int (*)(int, int, int, epoll_event *)>("epoll_ctl");
+
+		count(CALL_EPOLL_CTL);
+		return (real(epfd, op, fd, event));
+	}
+
+	// io_uring has no libc wrapper: the server calls syscall(__NR_io_uring_enter, ...) with 6 arguments
+	long	syscall(long number, ...)
+	{
+		static long	(*real)(long, ...) = next<long (*)(long, ...)>("syscall");
+		va_list		args;
+		long		arg[6];
+
+		va_start(args, number);
+		for (int i = 0; i < 6; i++)
+			arg[i] = va_arg(args, long);
+		va_end(args);
+		if (number == __NR_io_uring_enter)
+			count(CALL_IO_URING_ENTER);
+		return (real(number, arg[0], arg[1], arg[2], arg[3], arg[4], arg[5]));
+	}
+}
@@ -0,0 +1,161 @@
+"""Helpers of the integration tests: a server started on a free port, and raw IRC clients."""
+
+import os
+import socket
+import subprocess
+import sys
+import time
+
+PASSWORD = "pw"
+BINARY = os.environ.get("IRCSERV", os.path.join(os.path.dirname(__file__), "..", "..", "ircserv"))
+
+
+def free_port():
+    s = socket.socket()
+    s.bind(("127.0.0.1", 0))
+    port = s.getsockname()[1]
+    s.close()
+    return port
+
+
+class Server:
+    """ircserv running on a free port, stopped with SIGINT when the block ends"""
+
+    def __init__(self, **env):
+        self.port = free_port()
+        self.env = dict(os.environ, **{k: str(v) for k, v in env.items()})
+        self.process = None
+
+    def __enter__(self):
+        self.process = subprocess.Popen([BINARY, str(self.port), PASSWORD], env=self.env,
+                                        stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+        deadline = time.time() + 5
+        while time.time() < deadline:
+            try:
+                socket.create_connection(("127.0.0.1", self.port), timeout=1).close()
+                return self
+            except OSError:
+                time.sleep(0.05)
+        raise RuntimeError("server didn't start")
+
+    def __exit__(self, *exc):
+        self.process.send_signal(2)
+        try:
+            self.process.wait(timeout=5)
+        except subprocess.TimeoutExpired:
+            self.process.kill()
+            raise RuntimeError("server didn't stop on SIGINT")
+
+    def alive(self):
+        return self.process.poll() is None
+
+    def workers(self):
+        """pids of the worker processes (IRC_PROCESSES > 1)"""
+        with open("/proc/%d/task/%d/children" % (self.process.pid, self.process.pid)) as f:
+            return [int(pid) for pid in f.read().split()]
+
+    def worker_of(self, client):
+        """pid of the worker process serving a client"""
+        port = client.sock.getsockname()[1]
+        inode = None
+        with open("/proc/net/tcp") as f:
+            for line in f.readlines()[1:]:
+                fields = line.split()
+                local, remote = fields[1], fields[2]
+                if int(local.split(":")[1], 16) == self.port and int(remote.split(":")[1], 16) == port:
+                    inode = fields[9]
+        for pid in self.workers():
+            for fd in os.listdir("/proc/%d/fd" % pid):
+                try:
+                    if os.readlink("/proc/%d/fd/%s" % (pid, fd)) == "socket:[%s]" % inode:
+                        return pid
+                except OSError:
+                    pass
+        raise AssertionError("no worker serves %s" % client.nick)
+
+    def wait_workers(self, count, timeout=5):
+        deadline = time.time() + timeout
+        while len(self.workers()) != count:
+            if time.time() > deadline:
+                raise AssertionError("%d workers running, expected %d" % (len(self.workers()), count))
+            time.sleep(0.05)
+
+
+class Client:
+    def __init__(self, server, nick=None, wait=True):
+        """registers with nick if given, waits for the welcome if wait"""
+        self.sock = socket.create_connection(("127.0.0.1", server.port), timeout=5)
+        self.data = b""
+        self.nick = nick
+        if nick:
+            self.send("PASS " + PASSWORD, "NICK " + nick, "USER %s 0 * :%s" % (nick, nick))
+            if wait:
+                self.expect(b" 001 ")
+
+    def send(self, *lines):
+        self.sock.sendall("".join(line + "\r\n" for line in lines).encode())
+
+    def send_raw(self, data):
+        self.sock.sendall(data)
+
+    def expect(self, pattern, timeout=5):
+        """waits until pattern was received, returns what came before it (included)"""
+        deadline = time.time() + timeout
+        while pattern not in self.data:
+            self.sock.settimeout(max(deadline - time.time(), 0.01))
+            try:
+                chunk = self.sock.recv(65536)
+            except socket.timeout:
+                chunk = None
+            if not chunk:
+                raise AssertionError("%r not received, got %r" % (pattern, self.data[-300:]))
+            self.data += chunk
+        end = self.data.index(pattern) + len(pattern)
+        seen, self.data = self.data[:end], self.data[end:]
+        return seen
+
+    def received(self, pattern):
+        """whether pattern was received, without waiting"""
+        self.sock.setblocking(False)
+        try:
+            while True:
+                chunk = self.sock.recv(65536)
+                if not chunk:
+                    break
+                self.data += chunk
+        except BlockingIOError:
+            pass
+        self.sock.setblocking(True)
+        return pattern in self.data
+
+    def closed(self, timeout=5):
+        """whether the server closes the connection within timeout"""
+        deadline = time.time() + timeout
+        while time.time() < deadline:
+            self.sock.settimeout(max(deadline - time.time(), 0.01))
+            try:
+                chunk = self.sock.recv(65536)
+            except socket.timeout:
+                return False
+            except ConnectionResetError:
+                return True
+            if not chunk:
+                return True
+            self.data += chunk
+        return False
+
+    def close(self):
+        self.sock.close()
+
+
+def run(tests):
+    """runs the test functions, exits with 1 if one of them failed"""
+    failed = 0
+    for test in tests:
+        try:
+            test()
+            print("ok   %s" % test.__name__)
+        except Exception as e:
+            failed += 1
+            print("FAIL %s: %s" % (test.__name__, e))
+    sys.exit(1 if failed else 0)
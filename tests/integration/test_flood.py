@@ -0,0 +1,98 @@
+"""Flood control: a client with more than FLOOD_RECVQ_MAX bytes waiting is disconnected,
+the others are still served (default FLOOD_* values of ft_irc.hpp)"""
+
+import os
+import socket
+import struct
+import time
+from irc import Server, Client, run
+
+BURST = b"PRIVMSG bob :" + b"x" * 400 + b"\r\n"
+
+
+def flood(server, pause):
+    bob = Client(server, "bob")
+    flooder = Client(server, "flooder")
+    # about ten commands pay the burst, the next ones throttle the client
+    flooder.send(*["PRIVMSG bob :%d" % i for i in range(12)])
+    if pause:
+        time.sleep(0.5)		# paused before the burst: detected when its timer fires
+    flooder.send_raw(BURST * 30)
+    flooder.expect(b"Excess Flood")
+    assert flooder.closed(), "flooder not disconnected"
+
+    # the server still answers, to the clients already there and to new ones
+    bob.send("PING alive")
+    bob.expect(b"PONG")
+    Client(server, "carol").close()
+    bob.close()
+
+
+def cpu_time(server):
+    """seconds of CPU used by the server so far"""
+    with open("/proc/%d/stat" % server.process.pid) as f:
+        fields = f.read().rsplit(")", 1)[1].split()
+    return (int(fields[11]) + int(fields[12])) / os.sysconf("SC_CLK_TCK")
+
+
+def reset_while_paused(server):
+    """a throttled client's connection is reset: it is disconnected, the server doesn't spin"""
+    bob = Client(server, "bob")
+    flooder = Client(server, "flooder")
+    flooder.send(*["PRIVMSG bob :%d" % i for i in range(20)])
+    bob.expect(b":9\r\n")
+    time.sleep(0.2)
+    flooder.sock.setsockopt(socket.SOL_SOCKET, socket.SO_LINGER, struct.pack("ii", 1, 0))
+    flooder.close()
+    time.sleep(0.2)
+    start = cpu_time(server)
+    time.sleep(1)
+    assert cpu_time(server) - start < 0.5, "server spins on the reset connection"
+    bob.send("PRIVMSG flooder :still there?")
+    bob.expect(b" 401 ")
+    bob.close()
+
+
+def test_burst_while_paused():
+    with Server() as server:
+        flood(server, True)
+
+
+def test_burst_at_once():
+    with Server() as server:
+        flood(server, False)
+
+
+def test_burst_while_paused_threads():
+    with Server(IRC_REACTORS=2, IRC_WORKERS=2) as server:
+        flood(server, True)
+
+
+def test_reset_while_paused():
+    with Server() as server:
+        reset_while_paused(server)
+
+
+def test_reset_while_paused_threads():
+    with Server(IRC_REACTORS=2, IRC_WORKERS=2) as server:
+        reset_while_paused(server)
+
+
+def test_burst_while_paused_io_uring():
+    with Server(IRC_ENGINE="io_uring", IRC_REACTORS=2, IRC_WORKERS=2) as server:
+        flood(server, True)
+
+
+def test_burst_at_once_io_uring():
+    with Server(IRC_ENGINE="io_uring") as server:
+        flood(server, False)
+
+
+def test_reset_while_paused_io_uring():
+    with Server(IRC_ENGINE="io_uring") as server:
+        reset_while_paused(server)
+
+
+run([test_burst_while_paused, test_burst_at_once, test_burst_while_paused_threads,
+     test_reset_while_paused, test_reset_while_paused_threads,
+     test_burst_while_paused_io_uring, test_burst_at_once_io_uring, test_reset_while_paused_io_uring])
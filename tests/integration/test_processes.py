@@ -0,0 +1,231 @@
+"""Multi-process mode (IRC_PROCESSES): the Supervisor restarts a worker whatever the way
+it exits, and only stops all of them on a shutdown request; a channel is the same for
+the clients of every worker"""
+
+import os
+import signal
+import time
+from irc import Server, Client, run
+
+UPTIME = 2.5		# above WORKER_MIN_UPTIME: a worker exiting sooner stops everything
+
+
+def restarted(sig):
+    with Server(IRC_PROCESSES=2) as server:
+        server.wait_workers(2)
+        time.sleep(UPTIME)
+        old = server.workers()
+        os.kill(old[0], sig)
+        deadline = time.time() + 5
+        while old[0] in server.workers() or len(server.workers()) != 2:
+            assert server.alive() and time.time() < deadline, "worker not restarted"
+            time.sleep(0.05)
+        for nick in ["a", "b", "c", "d"]:
+            Client(server, nick).close()
+
+
+def test_restart_after_crash():
+    restarted(signal.SIGKILL)
+
+
+def test_restart_after_sigterm():
+    restarted(signal.SIGTERM)
+
+
+def test_restart_after_normal_exit():
+    restarted(signal.SIGINT)
+
+
+def test_ownership_while_worker_stuck():
+    """nicknames taken while a worker can't read its Bus reach it once it reads again"""
+    with Server(IRC_PROCESSES=2) as server:
+        server.wait_workers(2)
+        stuck = server.workers()[0]
+        os.kill(stuck, signal.SIGSTOP)
+        try:
+            # clients of the stopped worker wait in its backlog, the others are welcomed
+            clients = [Client(server, "n%d" % i, wait=False) for i in range(400)]
+            time.sleep(2)
+            served = [c for c in clients if c.received(b" 001 ")]
+            waiting = [c for c in clients if c not in served]
+
+            # enough nickname changes to fill the stopped worker's Bus
+            for c in served:
+                c.send(*["NICK %s_%d" % (c.nick, i) for i in range(5)])
+            for c in served:
+                c.nick += "_4"
+                c.expect(b"NICK :%s" % c.nick.encode())
+        finally:
+            os.kill(stuck, signal.SIGCONT)
+        assert served and waiting, "connections not spread among the workers"
+        for c in waiting:
+            c.expect(b" 001 ")
+
+        # every nickname of the other worker is known by the stopped one
+        sender = waiting[0]
+        sender.send("OPER bs 42")		# not throttled
+        sender.expect(b" 381 ")
+        sender.send(*["PRIVMSG %s :hello" % c.nick for c in served])
+        sender.send("PING done")
+        seen = sender.expect(b"PONG")
+        assert b" 401 " not in seen, "nicknames lost: %r" % seen[seen.index(b" 401 "):][:200]
+        for c in served:
+            c.expect(b"PRIVMSG %s :hello" % c.nick.encode())
+
+
+def test_claim_doesnt_block_worker():
+    """a NICK waiting for the Supervisor doesn't stop the other clients of its worker"""
+    with Server(IRC_PROCESSES=2) as server:
+        server.wait_workers(2)
+        clients = [Client(server, "c%d" % i) for i in range(8)]
+        claimer = clients[0]
+        neighbours = [c for c in clients[1:] if server.worker_of(c) == server.worker_of(claimer)]
+        assert neighbours, "no other client on the claimer's worker"
+
+        os.kill(server.process.pid, signal.SIGSTOP)
+        try:
+            claimer.send("NICK renamed", "PING after")
+            for c in neighbours:
+                c.send("PING alive")
+                c.expect(b"PONG")
+            assert not claimer.received(b"PONG"), "line after NICK executed before the answer"
+        finally:
+            os.kill(server.process.pid, signal.SIGCONT)
+
+        # the NICK ends once answered, then the lines after it are executed
+        seen = claimer.expect(b"PONG")
+        assert b"NICK :renamed" in seen, "NICK not answered before PONG: %r" % seen
+
+
+def on_two_workers(server, nick, other):
+    """two clients served by different workers"""
+    first = Client(server, nick)
+    for i in range(20):
+        second = Client(server, "%s%d" % (other, i))
+        if server.worker_of(second) != server.worker_of(first):
+            return first, second
+        second.close()
+    raise AssertionError("connections not spread among the workers")
+
+
+def test_channel_modes_across_workers():
+    """modes, invitations, topic and KICK of a channel apply to the clients of every worker,
+    whichever worker owns it"""
+    with Server(IRC_PROCESSES=2) as server:
+        server.wait_workers(2)
+        op, other = on_two_workers(server, "op", "other")
+        for chan in ["#c0", "#c1", "#c2", "#c3"]:
+            op.send("JOIN " + chan, "MODE %s +ik key" % chan)
+            op.expect(b"MODE %s +ik key" % chan.encode())
+
+            other.send("JOIN %s key" % chan)
+            other.expect(b" 473 ")
+            op.send("INVITE %s %s" % (other.nick, chan))
+            other.expect(b" INVITE ")
+            other.send("JOIN %s wrong" % chan)
+            other.expect(b" 475 ")
+            other.send("JOIN %s key" % chan)
+            other.expect(b" 366 ")
+            op.expect(b"JOIN :" + chan.encode())
+
+            op.send("PRIVMSG %s :from op" % chan, "TOPIC %s :topic" % chan)
+            other.expect(b"PRIVMSG %s :from op" % chan.encode())
+            other.expect(b"TOPIC %s :topic" % chan.encode())
+            other.send("PRIVMSG %s :from other" % chan)
+            op.expect(b"PRIVMSG %s :from other" % chan.encode())
+
+            op.send("KICK %s %s :bye" % (chan, other.nick))
+            other.expect(b"KICK %s %s :bye" % (chan.encode(), other.nick.encode()))
+            other.send("PRIVMSG %s :kicked" % chan)
+            other.expect(b" 404 ")
+            assert not op.received(b":kicked"), "kicked client still in the channel"
+
+
+def test_channel_members_across_workers():
+    """a client of another worker keeps its channels when it changes its nickname,
+    and leaves them when it quits"""
+    with Server(IRC_PROCESSES=2) as server:
+        server.wait_workers(2)
+        op, other = on_two_workers(server, "op", "other")
+        for chan in ["#m0", "#m1", "#m2", "#m3"]:
+            op.send("JOIN " + chan)
+            op.expect(b" 366 ")
+            other.send("JOIN " + chan)
+            op.expect(b"JOIN :" + chan.encode())
+
+        other.send("NICK renamed")
+        other.expect(b"NICK :renamed")
+        for chan in ["#m0", "#m1", "#m2", "#m3"]:
+            op.send("MODE %s +o renamed" % chan)
+            op.expect(b"MODE %s +o renamed" % chan.encode())
+
+        other.send("QUIT :gone")
+        for chan in ["#m0", "#m1", "#m2", "#m3"]:
+            op.expect(b"QUIT :Quit: gone")
+        for chan in ["#m0", "#m1", "#m2", "#m3"]:
+            op.send("MODE %s +o renamed" % chan)
+            op.expect(b" 401 ")
+
+
+def test_nickname_case_across_workers():
+    """a client is named as it chose, whatever the case its nickname is given in, by any worker"""
+    with Server(IRC_PROCESSES=2) as server:
+        server.wait_workers(2)
+        time.sleep(UPTIME)
+        alice, other = on_two_workers(server, "Alice", "other")
+        other.send("PRIVMSG aLICE :hi")
+        alice.expect(b" PRIVMSG Alice :hi\r\n")
+        alice.send("MODE ALICE")
+        alice.expect(b" 221 Alice ")
+        alice.send("MODE " + other.nick.upper())
+        alice.expect(b" 502 ")
+
+
+def test_channel_owner_exit():
+    """when a worker exits, the members of its channels served by another worker are kicked
+    from them (and can join them again), the channels of the other worker are kept"""
+    with Server(IRC_PROCESSES=2) as server:
+        server.wait_workers(2)
+        time.sleep(UPTIME)
+        op, other = on_two_workers(server, "op", "other")
+        chans = ["#o%d" % i for i in range(8)]
+        for chan in chans:
+            op.send("JOIN " + chan)
+            op.expect(b" 366 ")
+            other.send("JOIN " + chan)
+            other.expect(b" 366 ")
+
+        os.kill(server.worker_of(op), signal.SIGKILL)
+        seen = other.expect(b" QUIT ")
+        time.sleep(0.5)
+        other.received(b"")
+        seen += other.data
+        lost = [chan for chan in chans if ("KICK %s %s :Channel lost" % (chan, other.nick)).encode() in seen]
+        assert 0 < len(lost) < len(chans), "channels not spread among the workers: %r" % lost
+
+        server.wait_workers(2)
+        for chan in lost:
+            other.send("JOIN " + chan)
+            other.expect(("353 {0} = {1} :@{0}\r\n".format(other.nick, chan)).encode())
+        for chan in chans:
+            if chan not in lost:
+                other.send("PART " + chan)
+                other.expect(("PART %s\r\n" % chan).encode())
+
+
+def test_poweroff_stops_all():
+    with Server(IRC_PROCESSES=2) as server:
+        server.wait_workers(2)
+        time.sleep(UPTIME)		# the worker leaving isn't taken as a startup failure
+        admin = Client(server, "admin")
+        admin.send("OPER bs 42")
+        admin.expect(b" 381 ")
+        admin.send("POWEROFF")
+        server.process.wait(timeout=5)
+
+
+run([test_restart_after_crash, test_restart_after_sigterm, test_restart_after_normal_exit,
+     test_ownership_while_worker_stuck, test_claim_doesnt_block_worker,
+     test_channel_modes_across_workers, test_channel_members_across_workers, test_nickname_case_across_workers,
+     test_channel_owner_exit,
+     test_poweroff_stops_all])
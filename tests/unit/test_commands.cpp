@@ -0,0 +1,53 @@
+/*
+ * Test of commandId(): every command of the dispatch table is resolved to itself,
+ * whatever its case, and g_cmdSlots gives no slot to a name that is not a command
+ * (its prefixes, with a character more or changed).
+ */
+
+#include "ft_irc.hpp"
+
+static bool	expect(std::string const &name, e_cmdId expected)
+{
+	e_cmdId	id = commandId(name.data(), name.size());
+
+	if (id == expected)
+		return (true);
+	std::cout << "FAIL \"" << name << "\" resolved to " << id << " (" << commandName(id)
+		<< "), expected " << expected << std::endl;
+	return (false);
+}
+
+int	main()
+{
+	bool	ok = true;
+
+	for (int i = CMD_UNKNOWN + 1; i < CMD_COUNT; i++)
+	{
+		e_cmdId		id = static_cast<e_cmdId>(i);
+		std::string	name = commandName(id);
+		std::string	lower = name;
+		std::string	mixed = name;
+
+		for (size_t j = 0; j < name.size(); j++)
+		{
+			lower[j] = std::tolower(name[j]);
+			if (j % 2)
+				mixed[j] = lower[j];
+		}
+		ok &= expect(name, id) && expect(lower, id) && expect(mixed, id);
+
+		for (size_t len = 0; len < name.size(); len++)
+			ok &= expect(name.substr(0, len), CMD_UNKNOWN);
+		ok &= expect(name + "S", CMD_UNKNOWN);
+		for (size_t j = 0; j < name.size(); j++)
+		{
+			std::string	changed = name;
+
+			changed[j] = (changed[j] == 'X' ? 'Y' : 'X');
+			ok &= expect(changed, CMD_UNKNOWN);
+		}
+	}
+	ok &= expect("", CMD_UNKNOWN) && expect("NOTICE", CMD_UNKNOWN) && expect("WHO", CMD_UNKNOWN);
+	std::cout << (ok ? "ok   " : "FAIL ") << "commands (" << CMD_COUNT - 1 << " names)" << std::endl;
+	return (ok ? EXIT_SUCCESS : EXIT_FAILURE);
+}
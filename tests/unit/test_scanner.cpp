@@ -0,0 +1,113 @@
+/*
+ * Differential test of the Scanner: every implementation the CPU runs must give
+ * the same results as a plain loop, for random data (CR, LF, NUL, spaces, bytes
+ * >= 0x80) at random offsets and lengths, and for each position of a single match
+ * around the 16 and 32 bytes chunk boundaries.
+ * The data ends right before a PROT_NONE page: reading past the end crashes.
+ */
+
+#include "ft_irc.hpp"
+#include <sys/mman.h>
+
+#define ROUNDS		200000
+#define MAX_LEN		300
+#define PAGE		4096
+
+static char const	g_alphabet[] = "aZ:# \t\v\f\r\n\x80\xff";	// the NUL at the end is picked too
+static char const	g_needles[] = {'\n', '\r', '\0', ' ', '\x80'};
+
+static char const	*findByteRef(char const *begin, char const *end, char c)
+{
+	while (begin != end && *begin != c)
+		begin++;
+	return (begin);
+}
+
+/**
+ * @brief Compares the implementation with the plain loops on [begin, end)
+ * @return false (and prints the case) if one of them differs
+ */
+static bool	check(Scanner::s_impl const &impl, char const *begin, char const *end)
+{
+	for (size_t i = 0; i < sizeof(g_needles); i++)
+	{
+		if (impl.findByte(begin, end, g_needles[i]) != findByteRef(begin, end, g_needles[i]))
+		{
+			std::cout << "FAIL " << impl.name << " findByte(" << static_cast<int>(g_needles[i]) << ") on "
+				<< (end - begin) << " bytes at " << (reinterpret_cast<size_t>(begin) % 64) << std::endl;
+			return (false);
+		}
+	}
+	return (true);
+}
+
+/**
+ * @brief Random bytes, random length, the data is moved so that it ends at the guard page
+ */
+static bool	randomCases(Scanner::s_impl const &impl, char *pageEnd)
+{
+	for (int round = 0; round < ROUNDS; round++)
+	{
+		size_t	len = rand() % (MAX_LEN + 1);
+		char	*begin = pageEnd - len;
+
+		for (size_t i = 0; i < len; i++)
+		{
+			// mostly letters, so that the matches are not always in the first chunk
+			if (rand() % 8)
+				begin[i] = 'a' + rand() % 26;
+			else
+				begin[i] = g_alphabet[rand() % sizeof(g_alphabet)];
+		}
+		if (!check(impl, begin, pageEnd))
+			return (false);
+	}
+	return (true);
+}
+
+/**
+ * @brief One match (or none) at each position, for lengths around the chunk sizes
+ */
+static bool	boundaryCases(Scanner::s_impl const &impl, char *pageEnd)
+{
+	for (size_t len = 0; len <= 100; len++)
+	{
+		char	*begin = pageEnd - len;
+
+		for (size_t pos = 0; pos <= len; pos++)
+		{
+			for (size_t n = 0; n < sizeof(g_needles); n++)
+			{
+				memset(begin, 'x', len);
+				if (pos < len)
+					begin[pos] = g_needles[n];
+				if (!check(impl, begin, pageEnd))
+					return (false);
+			}
+		}
+	}
+	return (true);
+}
+
+int	main()
+{
+	std::vector<Scanner::s_impl>	impls = Scanner::getImpls();
+	char	*pages = static_cast<char *>(mmap(NULL, 2 * PAGE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+	int		failed = 0;
+
+	if (pages == MAP_FAILED || mprotect(pages + PAGE, PAGE, PROT_NONE) == ERROR)
+	{
+		std::cout << "FAIL " << strerror(errno) << std::endl;
+		return (EXIT_FAILURE);
+	}
+	srand(42);
+	for (std::vector<Scanner::s_impl>::iterator it = impls.begin(); it != impls.end(); it++)
+	{
+		if (randomCases(*it, pages + PAGE) && boundaryCases(*it, pages + PAGE))
+			std::cout << "ok   scanner " << it->name << std::endl;
+		else
+			failed++;
+	}
+	munmap(pages, 2 * PAGE);
+	return (failed ? EXIT_FAILURE : EXIT_SUCCESS);
+}